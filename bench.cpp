@@ -0,0 +1,178 @@
+#include "bench.h"
+#include "cmdhelper.h"
+#include "mainwindow.h"
+#include "pmuemulator.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstdio>
+
+benchRunner::benchRunner(QObject *parent) : QObject(parent),
+  m_sink(0),
+  m_minTimeNs(200000000),
+  m_out(stdout, QIODevice::WriteOnly),
+  m_err(stderr, QIODevice::WriteOnly) {
+}
+
+bool benchRunner::isRequested(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (QString::fromLocal8Bit(argv[i]) == "--bench") {
+      return true;
+    }
+  }
+  return false;
+}
+
+int benchRunner::run(QStringList arguments) {
+  QCommandLineParser parser;
+  QCommandLineOption helpOption = parser.addHelpOption();
+  QCommandLineOption benchOption("bench", "Run the benchmarks.");
+  QCommandLineOption jsonOption("json", "Print the results as a JSON document.");
+  QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains text.", "text");
+  QCommandLineOption timeOption("time", "Minimum time spent on each benchmark.", "ms", "200");
+  bool ok;
+  parser.setApplicationDescription("Digital Lumens Terminal, benchmarks");
+  parser.addOption(benchOption);
+  parser.addOption(jsonOption);
+  parser.addOption(filterOption);
+  parser.addOption(timeOption);
+  if (!parser.parse(arguments)) {
+    m_err << parser.errorText() << endl;
+    return 1;
+  }
+  if (parser.isSet(helpOption)) {
+    m_out << parser.helpText();
+    return 0;
+  }
+  m_minTimeNs = parser.value(timeOption).toLongLong(&ok) * 1000000;
+  if (!ok || (m_minTimeNs <= 0)) {
+    m_err << "--time expects a number of milliseconds" << endl;
+    return 1;
+  }
+  m_filter = parser.value(filterOption);
+
+  // a real looking event log, read one segment at a time like get log does
+  emulatorConfig_t config;
+  config.numLogEntries = 1000;
+  pmuEmulator pmu(1, config);
+  QString logIndex = pmu.issueCommand("K");
+  QList<QPair<int, QString> > segments;
+  int index = logIndex.left(4).toInt(&ok, 16);
+  int tail = logIndex.mid(4, 4).toInt(&ok, 16);
+  while (index != tail) {
+    QString segment = pmu.issueCommand("K" + toHexNum(index, 2));
+    QVector<logEntry_t> entries;
+    bool isLastEntry;
+    if (!eventLog::decode(segment, index, &entries, &isLastEntry) || entries.isEmpty()) {
+      break;
+    }
+    segments << qMakePair(index, segment);
+    index = (entries.last().index + 1) & 0xFFFF;
+  }
+  if (segments.isEmpty()) {
+    m_err << "Could not build the event log" << endl;
+    return 1;
+  }
+  // what a multi-line helper hands back to the window
+  QStringList response;
+  response << "+Up time: 2y 3d 4h 5m 6s"
+           << "+Active time: 1y 200d 0h 15m 0s"
+           << "OK"
+           << "ERROR: FFFD"
+           << "0C80"
+           << "+00A0 12:00:01 Power up<br>00A1 12:00:07 Light level: 4<br>00A2 12:04:51 Motion<br>";
+  QStringList requests;
+  requests << "get usage" << "get log 00A0" << "set serialNumber 12345678" << "get temperature --no-cache" << "G0004";
+  cmdHelper helper;
+
+  measure("parse_logIndex", [&]() {
+    return (qint64) parse_logIndex(logIndex).length();
+  });
+  measure("parse_log segment", [&]() {
+    return (qint64) parse_log(segments.first().first, segments.first().second).length();
+  });
+  measure("parse_log 1000 events", [&]() -> qint64 {
+    qint64 n = 0;
+    for (int i = 0; i < segments.length(); i++) {
+      n += parse_log(segments.at(i).first, segments.at(i).second).length();
+    }
+    return n;
+  });
+  measure("toYDHMS", [&]() {
+    return (qint64) toYDHMS("03C26700").length();
+  });
+  measure("toHexNum", [&]() {
+    return (qint64) toHexNum(m_sink & 0xFFFF, 2).length();
+  });
+  measure("cmdHelper::getCmdHandler", [&]() {
+    return (qint64) (bool) helper.getCmdHandler(requests.at(m_sink % requests.length()));
+  });
+  measure("MainWindow::formatResponse", [&]() {
+    return (qint64) MainWindow::formatResponse(response).length();
+  });
+
+  if (parser.isSet(jsonOption)) {
+    printJson();
+  } else {
+    printText();
+  }
+  return 0;
+}
+
+// repeats op in growing batches until a batch takes at least m_minTimeNs
+void benchRunner::measure(QString name, std::function<qint64(void)> op) {
+  QElapsedTimer timer;
+  qint64 iterations = 1;
+  qint64 elapsedNs;
+  if (!name.contains(m_filter, Qt::CaseInsensitive)) {
+    return;
+  }
+  forever {
+    timer.start();
+    for (qint64 i = 0; i < iterations; i++) {
+      m_sink += op();
+    }
+    elapsedNs = timer.nsecsElapsed();
+    if (elapsedNs >= m_minTimeNs) {
+      break;
+    }
+    // aim a little past the minimum so one more batch usually does it
+    qint64 estimate = (elapsedNs > 0) ? ((iterations * m_minTimeNs * 6) / (elapsedNs * 5)) : (iterations * 100);
+    iterations = qBound(iterations * 2, estimate, iterations * 100);
+  }
+  benchResult_t result;
+  result.name = name;
+  result.iterations = iterations;
+  result.nsPerOp = (double) elapsedNs / iterations;
+  m_results << result;
+}
+
+void benchRunner::printText(void) {
+  foreach (const benchResult_t &result, m_results) {
+    m_out << QString("%1 %2 ns/op (%3 iterations)")
+             .arg(result.name, -32)
+             .arg(result.nsPerOp, 12, 'f', 1)
+             .arg(result.iterations) << "\n";
+  }
+  m_out.flush();
+}
+
+// stable keys, so results from different releases can be compared
+void benchRunner::printJson(void) {
+  QJsonArray benchmarks;
+  foreach (const benchResult_t &result, m_results) {
+    QJsonObject benchmark;
+    benchmark.insert("name", result.name);
+    benchmark.insert("iterations", (double) result.iterations);
+    benchmark.insert("nsPerOp", result.nsPerOp);
+    benchmarks.append(benchmark);
+  }
+  QJsonObject document;
+  document.insert("qt", QString(qVersion()));
+  document.insert("minTimeMs", (double) (m_minTimeNs / 1000000));
+  document.insert("benchmarks", benchmarks);
+  m_out << QJsonDocument(document).toJson();
+  m_out.flush();
+}
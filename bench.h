@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+
+struct benchResult_t {
+  QString name;
+  qint64 iterations;
+  double nsPerOp;
+};
+
+// times the code that big log dumps and polling sessions spend their time
+// in. run with: dlterm --bench [--json]
+class benchRunner : public QObject
+{
+  Q_OBJECT
+public:
+  explicit benchRunner(QObject *parent = 0);
+  static bool isRequested(int argc, char *argv[]);
+  int run(QStringList arguments);
+
+private:
+  // keeps the compiler from optimizing the measured code away
+  qint64 m_sink;
+  qint64 m_minTimeNs;
+  QString m_filter;
+  QVector<benchResult_t> m_results;
+  QTextStream m_out;
+  QTextStream m_err;
+  void measure(QString name, std::function<qint64(void)> op);
+  void printText(void);
+  void printJson(void);
+};
+
+#endif // BENCH_H
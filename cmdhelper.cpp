@@ -1,41 +1,19 @@
 #include "cmdhelper.h"
 #include "interface.h"
+#include "registertable.h"
+#include "eventlog.h"
+#include "logstore.h"
+#include "logquery.h"
 #include "dllib.h"
 #include <QAbstractItemView>
+#include <QDateTime>
 #include <QEvent>
 #include <QKeyEvent>
 #include <QDebug>
 
 QString toYDHMS(QString timeInSec) {
   bool ok;
-  quint32 ulTimeInSec = timeInSec.toULong(&ok, 16);
-  QString outTime;
-  if (ulTimeInSec == 0) {
-    return "0S";
-  }
-  if (ulTimeInSec / 31536000) {
-    outTime += QString("%1Y:").arg(ulTimeInSec / 31536000);
-    ulTimeInSec %= 31536000;
-  }
-  if (ulTimeInSec / 86400) {
-    outTime += QString("%1D:").arg(ulTimeInSec / 86400);
-    ulTimeInSec %= 86400;
-  }
-  if (ulTimeInSec / 3600) {
-    outTime += QString("%1H:").arg(ulTimeInSec / 3600);
-    ulTimeInSec %= 3600;
-  }
-  if (ulTimeInSec / 60) {
-    outTime += QString("%1M:").arg(ulTimeInSec / 60);
-    ulTimeInSec %= 60;
-  }
-  if (ulTimeInSec) {
-    outTime += QString("%1S").arg(ulTimeInSec);
-  }
-  if (outTime.endsWith(":")) {
-    outTime.truncate(outTime.length() - 1);
-  }
-  return outTime;
+  return eventLog::uptimeString(timeInSec.toULong(&ok, 16));
 }
 
 QString toHexNum(int num, int size) {
@@ -49,70 +27,6 @@ QString toHexNum(int num, int size) {
 }
 
 /*** PMU register commands ***/
-QStringList get_firmwareVersion(QStringList argList, interface *iface) {
-  QStringList responseList;
-  (void) argList;
-  responseList = iface->queryPmu(QStringList() << "G0000");
-  if (responseList.at(0).startsWith("ERROR")) {
-    return responseList;
-  } else {
-    bool ok;
-    qulonglong verInt = responseList.at(0).toULongLong(&ok, 16);
-    // format verMajor.verMinor.verBuild (buildMonth/buildDay/BuildYear)
-    return QStringList() << (QString("+%1.%2.%3 (%5/%6/%4)").arg((verInt >> 40) & 0xFF).arg((verInt >> 32) & 0xFF).arg((verInt >> 24) & 0xFF).arg((verInt >> 16) & 0xFF).arg((verInt >> 8) & 0xFF).arg(verInt & 0xFF));
-  }
-}
-
-QStringList get_productCode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0001");
-}
-
-QStringList set_productCode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0001 %1").arg(argList.at(0)));
-}
-
-QStringList get_serialNumber(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0002");
-}
-
-QStringList set_serialNumber(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0002 %1").arg(argList.at(0)));
-}
-
-QStringList get_unixTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0003");
-}
-
-QStringList set_unixTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0003 %1").arg(argList.at(0)));
-}
-
-QStringList get_temperature(QStringList argList, interface *iface) {
-  QStringList responseList;
-  (void) argList;
-  responseList = iface->queryPmu(QStringList() << "G0004");
-  if (responseList.at(0).startsWith("ERROR")) {
-    return responseList;
-  } else {
-    bool ok;
-    quint16 tInt = responseList.at(0).toUShort(&ok, 16);
-    float tFloat = (tInt / 128);
-    return QStringList() << QString("+%1 C").arg(tFloat);
-  }
-}
-
 QStringList get_lightLevel(QStringList argList, interface *iface) {
   QStringList cmdList;
   QStringList responseList;
@@ -132,51 +46,6 @@ QStringList get_lightLevel(QStringList argList, interface *iface) {
                        << QString("+Override inactive level: %1").arg(responseList.at(5));
 }
 
-QStringList set_lightManualLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0005 %1").arg(argList.at(0)));
-}
-
-QStringList set_lightOverrideActiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0008 %1").arg(argList.at(0)));
-}
-
-QStringList set_lightOverrideInactiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0009 %1").arg(argList.at(0)));
-}
-
-QStringList get_sensorDelayTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G000A");
-}
-
-QStringList get_sensorOverrideDelayTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G000B");
-}
-
-QStringList set_sensorOverrideDelayTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S000B %1").arg(argList.at(0)));
-}
-
-QStringList get_upTime(QStringList argList, interface *iface) {
-  QStringList responseList;
-  (void) argList;
-  responseList = iface->queryPmu(QStringList() << "G000C");
-  return QStringList() << QString("+%1").arg(toYDHMS(responseList.at(0)));
-}
-
 QStringList get_usage(QStringList argList, interface *iface) {
   QStringList cmdList;
   QStringList responseList;
@@ -203,11 +72,6 @@ QStringList get_usage(QStringList argList, interface *iface) {
                        << QString("+Perm sensor events: %1").arg(responseList.at(8).toUShort(&ok, 16));
 }
 
-QStringList get_numLogEntries(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0015");
-}
-
 QStringList get_configCalibration(QStringList argList, interface *iface) {
   QStringList cmdList;
   QStringList responseList;
@@ -223,219 +87,6 @@ QStringList get_configCalibration(QStringList argList, interface *iface) {
                        << QString("+P3: %1").arg(responseList.at(3));
 }
 
-QStringList set_configCalibrationP0(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0016 %1").arg(argList.at(0)));
-}
-
-QStringList set_configCalibrationP1(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0017 %1").arg(argList.at(0)));
-}
-
-QStringList set_configCalibrationP2(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0018 %1").arg(argList.at(0)));
-}
-
-QStringList set_configCalibrationP3(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0019 %1").arg(argList.at(0)));
-}
-
-QStringList get_buildTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G001A");
-}
-
-QStringList set_buildTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S001A %1").arg(argList.at(0)));
-}
-
-QStringList get_sensorTimeoutCountdown(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G001B");
-}
-
-QStringList get_currentLightLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G001C");
-}
-
-QStringList get_safeMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G001D");
-}
-
-QStringList get_lightBarSelect(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G001E");
-}
-
-QStringList set_lightBarSelect(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S001E %1").arg(argList.at(0)));
-}
-
-QStringList get_powerConsumption(QStringList argList, interface *iface) {
-  QStringList responseList;
-  (void) argList;
-  responseList = iface->queryPmu(QStringList() << "G001F");
-  if (responseList.at(0).startsWith("ERROR")) {
-    return responseList;
-  } else {
-    bool ok;
-    quint16 powerInt = responseList.at(0).toUShort(&ok, 16);
-    return QStringList() << QString("+%1 mW").arg(powerInt);
-  }
-}
-
-QStringList get_wirelessDataAggregator(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0020");
-}
-
-QStringList set_wirelessDataAggregator(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0020 %1").arg(argList.at(0)));
-}
-
-QStringList get_resetUsageTimestamp(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0021");
-}
-
-QStringList get_pwmPeriodRegister(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0022");
-}
-
-QStringList set_pwmPeriodRegister(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0022 %1").arg(argList.at(0)));
-}
-
-QStringList get_analogSensorValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0023");
-}
-
-QStringList get_analogReportingHysteresis(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0024");
-}
-
-QStringList get_zone(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0025");
-}
-
-QStringList set_zone(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0025 %1").arg(argList.at(0)));
-}
-
-QStringList get_lightTemporaryActiveLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0026");
-}
-
-QStringList set_lightTemporaryActiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0026 %1").arg(argList.at(0)));
-}
-
-QStringList get_lightTemporaryInactiveLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0027");
-}
-
-QStringList set_lightTemporaryInactiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0027 %1").arg(argList.at(0)));
-}
-
-QStringList get_sensorTemporaryDelayTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0028");
-}
-
-QStringList set_sensorTemporaryDealyTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0028 %1").arg(argList.at(0)));
-}
-
-QStringList get_temporaryOverrideTimeout(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0029");
-}
-
-QStringList set_temporaryOverrideTiemout(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0029 %1").arg(argList.at(0)));
-}
-
-QStringList get_setRemoteState(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G002A");
-}
-
-QStringList set_setRemoteState(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S002A %1").arg(argList.at(0)));
-}
-
-QStringList get_remoteStateDelayTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G002B");
-}
-
-QStringList set_remoteStateDelayTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S002B %1").arg(argList.at(0)));
-}
-
-QStringList get_remoteSecondsCountdown(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G002C");
-}
-
-QStringList get_minimumDimmingValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G002D");
-}
-
 QStringList get_powerCalibration(QStringList argList, interface *iface) {
   QStringList cmdList;
   QStringList responseList;
@@ -461,184 +112,35 @@ QStringList get_powerCalibration(QStringList argList, interface *iface) {
                        << QString("+T0: %1").arg(responseList.at(8));
 }
 
-QStringList set_powerCalibrationA0(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S002E %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationB0(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S002F %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationC0(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0030 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationMA(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0031 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationMB(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0032 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationMC(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0033 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationPOff(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0034 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationPOn(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0035 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerCalibrationT0(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0036 %1").arg(argList.at(0)));
-}
-
-QStringList get_powerEstimatorTemperatureOverride(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0037");
-}
-
-QStringList set_powerEstimatorTemperatureOverride(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0037 %1").arg(argList.at(0)));
-}
-
-QStringList get_cachedTemperatureValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0038");
-}
-
-QStringList get_eepromSize(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0039");
-}
-
-QStringList get_hardwareRevision(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G003A");
-}
-
-QStringList get_wirelessConfig(QStringList argList, interface *iface) {
-  QStringList cmdList;
-  QStringList responseList;
-  (void) argList;
-  cmdList << "G003B" // pan id
-          << "G003C" // channel mask
-          << "G003D" // short address
-          << "G003E" // role
-          << "G003F" // watchdog hold
-          << "G0040" // watchdog period
-          << "G0073"; // network key
-  responseList = iface->queryPmu(cmdList);
-  bool ok;
-  unsigned long long panid = responseList.at(0).toULongLong(&ok, 16);
-  unsigned long chmask = responseList.at(1).toULong(&ok, 16);
-  unsigned group;
-  unsigned freq;
-  bool encrypted;
-  LRNetwork::groupAndFreqFromPanidAndChmask(panid, chmask, &group, &freq, &encrypted);
-  QString netId = LRNetwork::nwidFromGroupAndFreq(group, freq, encrypted);
-  QStringList parsedResponse;
-  return QStringList() << QString("+Network ID: %1").arg(netId)
-                       << QString("+Pan ID: %1").arg(responseList.at(0))
-                       << QString("+Channel mask: %1").arg(responseList.at(1))
-                       << QString("+Short address: %1").arg(responseList.at(2))
-                       << QString("+Role: %1").arg(responseList.at(3))
-                       << QString("+Watchdog hold: %1").arg(responseList.at(4))
-                       << QString("+Watchdog period: %1").arg(responseList.at(5))
-                       << QString("+Network key: %1").arg(responseList.at(6));
-}
-
-QStringList set_wirelessPanId(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S003B %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessChannelMask(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S003C %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessShortAddress(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S003D %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessRole(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S003E %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessWatchdogHold(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S003F %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessWatchdogPeriod(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0040 %1").arg(argList.at(0)));
-}
-
-QStringList set_wirelessNetworkKey(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0073 %1").arg(argList.at(0)));
-}
-
-QStringList get_firmwareCode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0041");
-}
-
-QStringList get_moduleFirmwareCode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0042");
+QStringList get_wirelessConfig(QStringList argList, interface *iface) {
+  QStringList cmdList;
+  QStringList responseList;
+  (void) argList;
+  cmdList << "G003B" // pan id
+          << "G003C" // channel mask
+          << "G003D" // short address
+          << "G003E" // role
+          << "G003F" // watchdog hold
+          << "G0040" // watchdog period
+          << "G0073"; // network key
+  responseList = iface->queryPmu(cmdList);
+  bool ok;
+  unsigned long long panid = responseList.at(0).toULongLong(&ok, 16);
+  unsigned long chmask = responseList.at(1).toULong(&ok, 16);
+  unsigned group;
+  unsigned freq;
+  bool encrypted;
+  LRNetwork::groupAndFreqFromPanidAndChmask(panid, chmask, &group, &freq, &encrypted);
+  QString netId = LRNetwork::nwidFromGroupAndFreq(group, freq, encrypted);
+  QStringList parsedResponse;
+  return QStringList() << QString("+Network ID: %1").arg(netId)
+                       << QString("+Pan ID: %1").arg(responseList.at(0))
+                       << QString("+Channel mask: %1").arg(responseList.at(1))
+                       << QString("+Short address: %1").arg(responseList.at(2))
+                       << QString("+Role: %1").arg(responseList.at(3))
+                       << QString("+Watchdog hold: %1").arg(responseList.at(4))
+                       << QString("+Watchdog period: %1").arg(responseList.at(5))
+                       << QString("+Network key: %1").arg(responseList.at(6));
 }
 
 QStringList get_maxTemperature(QStringList argList, interface *iface) {
@@ -647,467 +149,87 @@ QStringList get_maxTemperature(QStringList argList, interface *iface) {
   (void) argList;
   cmdList << "G0043" // observed temperature
           << "G0044"; // observed time
-  responseList = iface->queryPmu(cmdList);
-  QString temperature = responseList.at(0);
-  QString time = responseList.at(1);
-  time = (time.startsWith("ERROR")) ? time : toYDHMS(time);
-  return QStringList() << QString("+Temperature: %1").arg(temperature)
-                       << QString("+Time: %1").arg(time);
-}
-
-QStringList get_overTemperatureConfig(QStringList argList, interface *iface) {
-  QStringList cmdList;
-  QStringList responseList;
-  (void) argList;
-  cmdList << "G0045" // low threshold
-          << "G0046" // high threshold
-          << "G0047"; // dimming limit
-  responseList = iface->queryPmu(cmdList);
-  return QStringList() << QString("+Low threshold: %1").arg(responseList.at(0))
-                       << QString("+High threshold: %1").arg(responseList.at(1))
-                       << QString("+Dimming limit: %1").arg(responseList.at(2));
-}
-
-QStringList set_overTemperatureThresholdLow(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0045 %1").arg(argList.at(0)));
-}
-
-QStringList get_overTemperatureThresholdHigh(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0046");
-}
-
-QStringList set_overTemperatureThresholdHigh(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0046 %1").arg(argList.at(0)));
-}
-
-QStringList set_overTemperatureDimmingLimit(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0047 %1").arg(argList.at(0)));
-}
-
-QStringList get_analogDimmingMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0048");
-}
-
-QStringList parse_get_analogDimmingMode(QStringList responseList) {
-  QMap <QString, QString> analogDimmingModeDict;
-  analogDimmingModeDict.insert("00", "Analog dimming off");
-  analogDimmingModeDict.insert("01", "Analog dimming on");
-  analogDimmingModeDict.insert("02", "Analog dimming on with ability to go full off");
-  analogDimmingModeDict.insert("03", "Analog dimming using registers 54-56");
-  analogDimmingModeDict.insert("04", "Analog dimming using registers 54-56 with full off support");
-  analogDimmingModeDict.insert("05", "Ambient sensor dimming");
-  return QStringList() << QString("+%1").arg(analogDimmingModeDict[responseList.at(0)]);
-}
-
-QStringList set_analogDimmingMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0048 %1").arg(argList.at(0)));
-}
-
-QStringList get_fixtureIdMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0049");
-}
-
-QStringList set_fixtureIdMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0049 %1").arg(argList.at(0)));
-}
-
-QStringList get_acFrequency(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004A");
-}
-
-QStringList get_sensorBits(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004B");
-}
-
-QStringList get_powerMeterCommand(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004C");
-}
-
-QStringList set_powerMeterCommand(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S004C %1").arg(argList.at(0)));
-}
-
-QStringList get_powerMeterRegister(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004D");
-}
-
-QStringList set_powerMeterRegister(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S004D %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientTemperature(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004E");
-}
-
-QStringList get_lightSensorLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G004F");
-}
-
-QStringList get_sensorConfig(QStringList argList, interface *iface) {
-  QStringList cmdList;
-  QStringList responseList;
-  (void) argList;
-  cmdList << "G004F" // sensor level
-          << "G0050" // sensor 0 timeout
-          << "G0051" // sensor 0 offset
-          << "G0052" // sensor 1 timeout
-          << "G0053"; // sensor 1 offset
-  responseList = iface->queryPmu(cmdList);
-  return QStringList() << QString("+Sensor level: %1").arg(responseList.at(0))
-                       << QString("+Sensor 0 timeout: %1").arg(responseList.at(1))
-                       << QString("+Sensor 0 offset: %1").arg(responseList.at(2))
-                       << QString("+Sensor 1 timeout: %1").arg(responseList.at(3))
-                       << QString("+Sensor 1 offset: %1").arg(responseList.at(4));
-}
-
-QStringList set_sensor0Timeout(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0050 %1").arg(argList.at(0)));
-}
-
-QStringList get_sensor0Offset(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0051");
-}
-
-QStringList set_sensor0Offset(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0051 %1").arg(argList.at(0)));
-}
-
-QStringList get_sensor1Timeout(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0052");
-}
-
-QStringList set_sensor1Timeout(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0052 %1").arg(argList.at(0)));
-}
-
-QStringList get_sensor1Offset(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0053");
-}
-
-QStringList set_sensor1Offset(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0053 %1").arg(argList.at(0)));
-}
-
-QStringList get_analogDimmingConfig(QStringList argList, interface *iface) {
-  QStringList cmdList;
-  QStringList responseList;
-  (void) argList;
-  cmdList << "G0054" // low value
-          << "G0055" // high value
-          << "G0056"; // off value
-  responseList = iface->queryPmu(cmdList);
-  return QStringList() << QString("+Low value: %1").arg(responseList.at(0))
-                       << QString("+High value: %1").arg(responseList.at(1))
-                       << QString("+Off value: %1").arg(responseList.at(2));
-}
-
-QStringList set_analogDimmingLowValue(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0054 %1").arg(argList.at(0)));
-}
-
-QStringList get_analogDimmingHighValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0055");
-}
-
-QStringList set_analogDimmingHighValue(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0055 %1").arg(argList.at(0)));
-}
-
-QStringList get_analogDimmingOffValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0056");
-}
-
-QStringList set_analogDimmingOffValue(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0056 %1").arg(argList.at(0)));
-}
-
-QStringList get_powerMeasurementMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0057");
-}
-
-QStringList set_powerMeasurementMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0057 %1").arg(argList.at(0)));
-}
-
-QStringList get_externalPowerMeter(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0058");
-}
-
-QStringList set_externalPowerMeter(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0058 %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientSensorValue(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0059");
-}
-
-QStringList get_ambientConfig(QStringList argList, interface *iface) {
-  QStringList cmdList;
-  QStringList responseList;
-  (void) argList;
-  cmdList << "G0059" // sensor value
-          << "G005A" // active level
-          << "G005B" // inactive level
-          << "G005C" // environmental gain
-          << "G005D" // off hysteresis
-          << "G005E" // on hysteresis
-          << "G0069"; // divisor
-  responseList = iface->queryPmu(cmdList);
-  return QStringList() << QString("+Sensor value: %1").arg(responseList.at(0))
-                       << QString("+Active level: %1").arg(responseList.at(1))
-                       << QString("+Inactive level: %1").arg(responseList.at(2))
-                       << QString("+Environmental gain: %1").arg(responseList.at(3))
-                       << QString("+Off hysteresis: %1").arg(responseList.at(4))
-                       << QString("+On hysteresis: %1").arg(responseList.at(5))
-                       << QString("+Divisor: %1").arg(responseList.at(6));
-}
-
-QStringList set_ambientActiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S005A %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientInactiveLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G005B");
-}
-
-QStringList set_ambientInactiveLevel(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S005B %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientEnvironmentalGain(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G005C");
-}
-
-QStringList set_ambientEnvironmentalGain(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S005C %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientOffHysteresis(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G005D");
-}
-
-QStringList set_ambientOffHysteresis(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S005D %1").arg(argList.at(0)));
-}
-
-QStringList get_ambientOnHysteresis(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G005E");
-}
-
-QStringList set_ambientOnHysteresis(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S005E %1").arg(argList.at(0)));
-}
-
-QStringList get_powerboardProtocol(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G005F");
-}
-
-QStringList get_ledOverride(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0060");
-}
-
-QStringList set_ledOverride(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0060 %1").arg(argList.at(0)));
-}
-
-QStringList get_fadeUpStep(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0061");
-}
-
-QStringList set_fadeUpStep(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0061 %1").arg(argList.at(0)));
-}
-
-QStringList get_fadeDownStep(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0062");
-}
-
-QStringList set_fadeDownStep(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0062 %1").arg(argList.at(0)));
-}
-
-QStringList get_maxBrightness(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0063");
-}
-
-QStringList set_maxBrightness(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0063 %1").arg(argList.at(0)));
-}
-
-QStringList get_i2cResets(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0064");
-}
-
-QStringList get_sensorGuardTime(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0065");
-}
-
-QStringList set_sensorGuardTime(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0065 %1").arg(argList.at(0)));
-}
-
-QStringList get_inputVoltage(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0066");
-}
-
-QStringList get_inputVoltageCalibration(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0067");
-}
-
-QStringList set_inputVoltageCalibration(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0067 %1").arg(argList.at(0)));
+  responseList = iface->queryPmu(cmdList);
+  QString temperature = responseList.at(0);
+  QString time = responseList.at(1);
+  time = (time.startsWith("ERROR")) ? time : toYDHMS(time);
+  return QStringList() << QString("+Temperature: %1").arg(temperature)
+                       << QString("+Time: %1").arg(time);
 }
 
-QStringList get_numLightbars(QStringList argList, interface *iface) {
+QStringList get_overTemperatureConfig(QStringList argList, interface *iface) {
+  QStringList cmdList;
+  QStringList responseList;
   (void) argList;
-  return iface->queryPmu(QStringList() << "G0068");
+  cmdList << "G0045" // low threshold
+          << "G0046" // high threshold
+          << "G0047"; // dimming limit
+  responseList = iface->queryPmu(cmdList);
+  return QStringList() << QString("+Low threshold: %1").arg(responseList.at(0))
+                       << QString("+High threshold: %1").arg(responseList.at(1))
+                       << QString("+Dimming limit: %1").arg(responseList.at(2));
 }
 
-QStringList set_numLightbars(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0068 %1").arg(argList.at(0)));
+QStringList parse_get_analogDimmingMode(QStringList responseList) {
+  QMap <QString, QString> analogDimmingModeDict;
+  analogDimmingModeDict.insert("00", "Analog dimming off");
+  analogDimmingModeDict.insert("01", "Analog dimming on");
+  analogDimmingModeDict.insert("02", "Analog dimming on with ability to go full off");
+  analogDimmingModeDict.insert("03", "Analog dimming using registers 54-56");
+  analogDimmingModeDict.insert("04", "Analog dimming using registers 54-56 with full off support");
+  analogDimmingModeDict.insert("05", "Ambient sensor dimming");
+  return QStringList() << QString("+%1").arg(analogDimmingModeDict[responseList.at(0)]);
 }
 
-QStringList get_currentLimit(QStringList argList, interface *iface) {
+QStringList get_sensorConfig(QStringList argList, interface *iface) {
+  QStringList cmdList;
+  QStringList responseList;
   (void) argList;
-  return iface->queryPmu(QStringList() << "G006A");
-}
-
-QStringList set_currentLimit(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S006A %1").arg(argList.at(0)));
+  cmdList << "G004F" // sensor level
+          << "G0050" // sensor 0 timeout
+          << "G0051" // sensor 0 offset
+          << "G0052" // sensor 1 timeout
+          << "G0053"; // sensor 1 offset
+  responseList = iface->queryPmu(cmdList);
+  return QStringList() << QString("+Sensor level: %1").arg(responseList.at(0))
+                       << QString("+Sensor 0 timeout: %1").arg(responseList.at(1))
+                       << QString("+Sensor 0 offset: %1").arg(responseList.at(2))
+                       << QString("+Sensor 1 timeout: %1").arg(responseList.at(3))
+                       << QString("+Sensor 1 offset: %1").arg(responseList.at(4));
 }
 
-QStringList get_bootloaderCode(QStringList argList, interface *iface) {
+QStringList get_analogDimmingConfig(QStringList argList, interface *iface) {
+  QStringList cmdList;
+  QStringList responseList;
   (void) argList;
-  return iface->queryPmu(QStringList() << "G006B");
+  cmdList << "G0054" // low value
+          << "G0055" // high value
+          << "G0056"; // off value
+  responseList = iface->queryPmu(cmdList);
+  return QStringList() << QString("+Low value: %1").arg(responseList.at(0))
+                       << QString("+High value: %1").arg(responseList.at(1))
+                       << QString("+Off value: %1").arg(responseList.at(2));
 }
 
-QStringList get_xpressMode(QStringList argList, interface *iface) {
+QStringList get_ambientConfig(QStringList argList, interface *iface) {
+  QStringList cmdList;
+  QStringList responseList;
   (void) argList;
-  return iface->queryPmu(QStringList() << "G006C");
-}
-
-QStringList set_xpressMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S006C %1").arg(argList.at(0)));
+  cmdList << "G0059" // sensor value
+          << "G005A" // active level
+          << "G005B" // inactive level
+          << "G005C" // environmental gain
+          << "G005D" // off hysteresis
+          << "G005E" // on hysteresis
+          << "G0069"; // divisor
+  responseList = iface->queryPmu(cmdList);
+  return QStringList() << QString("+Sensor value: %1").arg(responseList.at(0))
+                       << QString("+Active level: %1").arg(responseList.at(1))
+                       << QString("+Inactive level: %1").arg(responseList.at(2))
+                       << QString("+Environmental gain: %1").arg(responseList.at(3))
+                       << QString("+Off hysteresis: %1").arg(responseList.at(4))
+                       << QString("+On hysteresis: %1").arg(responseList.at(5))
+                       << QString("+Divisor: %1").arg(responseList.at(6));
 }
 
 QStringList get_batteryBackupStatus(QStringList argList, interface *iface) {
@@ -1156,88 +278,6 @@ QStringList get_batteryBackupStatus(QStringList argList, interface *iface) {
   }
 }
 
-QStringList set_batteryBackupStatus(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S006D %1").arg(argList.at(0)));
-}
-
-QStringList get_sensorSeconds(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G006E");
-}
-
-QStringList get_inputVoltageTwo(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G006F");
-}
-
-QStringList get_inputVoltageTwoCalibration(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0070");
-}
-
-QStringList set_inputVoltageTwoCalibration(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0070 %1").arg(argList.at(0)));
-}
-
-QStringList get_maxRampUpSpeed(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0071");
-}
-
-QStringList set_maxRampUpSpeed(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0071 %1").arg(argList.at(0)));
-}
-
-QStringList get_maxRampDownSpeed(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0072");
-}
-
-QStringList set_maxRampDownSpeed(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0072 %1").arg(argList.at(0)));
-}
-
-QStringList get_emergencyLightLevel(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0074");
-}
-
-QStringList get_batteryBackupPowerCalibration(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0075");
-}
-
-QStringList set_batteryBackupPowerCalibration(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0075 %1").arg(argList.at(0)));
-}
-
-QStringList get_motionSensorProfile(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G0076");
-}
-
-QStringList set_motionSensorProfile(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0076 %1").arg(argList.at(0)));
-}
-
 QStringList get_powerMeterConfig(QStringList argList, interface *iface) {
   QStringList cmdList;
   QStringList responseList;
@@ -1253,75 +293,6 @@ QStringList get_powerMeterConfig(QStringList argList, interface *iface) {
                        << QString("+Type: %1").arg(responseList.at(3));
 }
 
-QStringList set_powerMeterLevelAtOff(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0077 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerMeterLevelAtMin(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0078 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerMeterLevelAtMax(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S0079 %1").arg(argList.at(0)));
-}
-
-QStringList set_powerMeterType(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S007A %1").arg(argList.at(0)));
-}
-
-QStringList get_DLAiSlaveMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G007B");
-}
-
-QStringList set_DLAiSlaveMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S007B %1").arg(argList.at(0)));
-}
-
-QStringList get_DALIBootlodingActive(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G007C");
-}
-
-QStringList get_testingMode(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G007D");
-}
-
-QStringList set_testingMode(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S007D %1").arg(argList.at(0)));
-}
-
-QStringList get_numBatteriesSupported(QStringList argList, interface *iface) {
-  (void) argList;
-  return iface->queryPmu(QStringList() << "G007E");
-}
-
-QStringList set_numBatteriesSupported(QStringList argList, interface *iface) {
-  if (argList.length() == 0) {
-    return QStringList() << "ERROR: expected a value";
-  }
-  return iface->queryPmu(QStringList() << QString("S007E %1").arg(argList.at(0)));
-}
-
 /*** lightbar register commands ***/
 QStringList get_lbVersion(QStringList argList, interface *iface) {
   QString barNum;
@@ -1962,124 +933,14 @@ QStringList parse_logIndex(QString response) {
 }
 
 QStringList parse_log(int startIndex, QString response) {
-  QString element;
-  int uptimeSize, valueSize, baseTime, uptime;
-  QString eventType, eventValue;
-  QStringList log;
-  bool ok;
+  QVector<logEntry_t> entries;
   bool isLastEntry;
-  QString timestamp;
-  QString index;
-  int numEvents = 0;
-  element = response;
-  baseTime = 0;
-  do {
-    // assemble log entry
-    uptimeSize = element.left(1).toInt(&ok, 16);
-    // most significant bit of uptime size is last entry indicator
-    if (uptimeSize > 7) {
-      isLastEntry = true;
-      uptimeSize -= 8;
-    } else {
-      isLastEntry = false;
-    }
-    // strip elements from the log entry
-    element.remove(0, 1);
-    valueSize = element.left(1).toInt(&ok, 16);
-    element.remove(0, 1);
-    eventType = element.left(2);
-    element.remove(0, 2);
-    uptime = element.left(uptimeSize * 2).toInt(&ok, 16);
-    element.remove(0, uptimeSize * 2);
-    eventValue = element.left(valueSize * 2);
-    element.remove(0, valueSize * 2);
-    // compute uptime
-    if (uptimeSize == 4) {
-      baseTime = uptime;
-    } else {
-      uptime += baseTime;
-      baseTime = uptime;
-    }
-    timestamp = toHexNum(uptime, 4);
-    timestamp = toYDHMS(timestamp);
-    index = toHexNum(startIndex + numEvents, 2);
-    numEvents++;
-    // parse log entry
-    if (eventType == "00") {
-      // build a dictionary of power events
-      QMap <QString, QString> powerEventsMap;
-      powerEventsMap.insert("00", "Power down");
-      powerEventsMap.insert("01", "Power up");
-      powerEventsMap.insert("02", "Power restored");
-      powerEventsMap.insert("03", "Power soft reset");
-      log << QString("+%1 %2 > %3").arg(index).arg(timestamp).arg(powerEventsMap[eventValue]);
-    } else if (eventType == "01") {
-      // build a dictionary of activity state transition events
-      QMap <QString, QString> activityStateTransitionEventsMap;
-      activityStateTransitionEventsMap.insert("00", "Fixture inactive");
-      activityStateTransitionEventsMap.insert("01", "Sensor 0 active");
-      activityStateTransitionEventsMap.insert("02", "Sensor 1 active");
-      activityStateTransitionEventsMap.insert("03", "Sensor 0 & Sensor 1 active");
-      activityStateTransitionEventsMap.insert("04", "Remote sensor active");
-      activityStateTransitionEventsMap.insert("05", "Remote sensor & sensor 0 active");
-      activityStateTransitionEventsMap.insert("06", "Remote sensor & sensor 1 active");
-      activityStateTransitionEventsMap.insert("07", "Remote sensor, sensor 0, and sensor 1 active");
-      log << QString("+%1 %2 > %3").arg(index).arg(timestamp).arg(activityStateTransitionEventsMap[eventValue]);
-    } else if (eventType == "02") {
-      // type 2 events are not implemented
-      log << QString("+%1 %2 > Type 2 event: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "03") {
-      log << QString("+%1 %2 > Sensor off: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "04") {
-      // unspecified value
-      log << QString("+%1 %2 > SerialNet watchdog tripped").arg(index).arg(timestamp);
-    } else if (eventType == "05") {
-      log << QString("+%1 %2 > Temperature state change: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "06") {
-      log << QString("+%1 %2 > Lightbar error: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "07") {
-      log << QString("+%1 %2 > RTC set event: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "08") {
-      int batteryNumber;
-      // build a dictionary of battery backup events
-      QMap <QString, QString> batteryBackupEventsMap;
-      batteryBackupEventsMap.insert("00", "Power activated");
-      batteryBackupEventsMap.insert("01", "Power deactivated");
-      batteryBackupEventsMap.insert("02", "Power failure [battery disconnected]");
-      batteryBackupEventsMap.insert("03", "Power failure [battery over temperature]");
-      batteryBackupEventsMap.insert("04", "Power failure [lightbar current sourced from PSU, not battery]");
-      batteryBackupEventsMap.insert("05", "Power failure [backup power voltage out of range]");
-      batteryBackupEventsMap.insert("06", "Power failure [battery drained]");
-      batteryBackupEventsMap.insert("07", "Power failure [unexpected lightbar pattern or pattern could not be verified]");
-      batteryBackupEventsMap.insert("08", "Battery test started");
-      batteryBackupEventsMap.insert("09", "Battery test stopped");
-      batteryBackupEventsMap.insert("0A", "Error [battery disconnected]");
-      batteryBackupEventsMap.insert("0B", "Error [charge temperature exceeded]");
-      batteryBackupEventsMap.insert("0C", "Last error cleared");
-      batteryBackupEventsMap.insert("0D", "Power failure [UL/CE mismatch]");
-      // parse battery number from event value
-      if (eventValue.at(0) != '0') {
-        eventValue.replace(0, 1, "0");
-        batteryNumber = 1;
-      } else {
-        batteryNumber = 0;
-      }
-      log << QString("+%1 %2 > Battery backup %3 event: %4").arg(index).arg(timestamp).arg(batteryNumber).arg(batteryBackupEventsMap[eventValue]);
-    } else if (eventType == "09") {
-      log << QString("+%1 %2 > I2C watchdog reset event: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else if (eventType == "0A") {
-      // unspecified value
-      log << QString("+%1 %2 > Registers restored from backup").arg(index).arg(timestamp);
-    } else if (eventType == "0B") {
-      // unspecified value
-      log << QString("+%1 %2 > Ember reset reason: %3").arg(index).arg(timestamp).arg(eventValue);
-    } else {
-      // unknown event
-      log << QString("+%1 %2 > Type %3 event: %4").arg(index).arg(timestamp).arg(eventType).arg(eventValue);
-    }
-  } while (element.isEmpty() != true);
+  bool ok = eventLog::decode(response, startIndex, &entries, &isLastEntry);
+  QStringList log = eventLog::format(entries);
   // notify the user that more logs are available
-  if (isLastEntry == true) {
+  if (!ok) {
+    log << "ERROR: Malformed log entry";
+  } else if (isLastEntry == true) {
     log << "+[End of log]";
   } else {
     log << QString("+[More events available...]");
@@ -2087,48 +948,168 @@ QStringList parse_log(int startIndex, QString response) {
   return log;
 }
 
+// serial number of the fixture a helper talks to, or 0 if none is
+// connected. PMUs on USB are known by serial number too, see
+// interface::addUSBFixtures().
+static quint32 fixtureSerialNumber(interface *iface) {
+  return iface->currentFixture();
+}
+
 QStringList get_log(QStringList argList, interface *iface) {
   bool ok;
   QStringList responseList;
-  QStringList logIndex;
-  QStringList logSegment;
-  QStringList log;
-  QString firstIndex;
+  logIndex_t logIndex;
+  QVector<logEntry_t> entries;
+  quint32 serialNumber;
   int startIndex;
-  QString endTag;
-  if (argList.length() == 0) {
-    // find most recent power up event
-    responseList = iface->queryPmu(QStringList() << QString("K"));
-    logIndex = parse_logIndex(responseList.at(0));
-    // expected +first: firstIndex
-    firstIndex = (QStringList() << logIndex.at(2).split(" ")).at(1);
-    if (firstIndex == "none") {
-      return QStringList() << "[No recent events]";
-    }
-    startIndex = firstIndex.toInt(&ok, 16);
-  } else if (argList.contains("index")) {
+  int nextIndex;
+  QString error;
+  QString notice;
+  QStringList log;
+  // read the head, tail and first indexes once
+  responseList = iface->queryPmu(QStringList() << QString("K"));
+  if (argList.contains("index")) {
     // display index
-    responseList = iface->queryPmu(QStringList() << QString("K"));
     return parse_logIndex(responseList.at(0));
-  } else {
+  }
+  if (responseList.at(0).startsWith("ERROR")) {
+    return responseList;
+  }
+  if (!eventLog::parseIndex(responseList.at(0), &logIndex)) {
+    return QStringList() << "ERROR: Malformed log index";
+  }
+  serialNumber = fixtureSerialNumber(iface);
+  if (!argList.isEmpty() && !argList.contains("resume") && !argList.contains("all")) {
+    // an explicit start index bypasses the log store
     startIndex = argList.at(0).toInt(&ok, 16);
+    if (!ok) {
+      return QStringList() << "ERROR: expected a hex log index";
+    }
+    error = eventLog::download(iface, startIndex, logIndex.tail, &entries, &nextIndex);
+  } else if (serialNumber == 0) {
+    return QStringList() << "ERROR: Could not read the serial number of the fixture";
+  } else {
+    // only download what was added since the last sync, in this or an earlier session
+    logStore store(serialNumber);
+    int numNewEntries;
+    if (!store.load()) {
+      return QStringList() << "ERROR: Could not read the log store";
+    }
+    error = store.sync(iface, logIndex, &numNewEntries);
+    entries = store.entries();
+    // keep the typed entries around for query log
+    logQuery::shared()->setEntries(serialNumber, entries);
+    if (argList.contains("resume")) {
+      // just the entries added since the last sync
+      entries = entries.mid(entries.size() - numNewEntries);
+    } else if (!argList.contains("all")) {
+      // start at the most recent power up event
+      if (logIndex.first < 0) {
+        return QStringList() << "[No recent events]";
+      }
+      int i = entries.size() - 1;
+      while ((i >= 0) && (entries.at(i).index != logIndex.first)) {
+        i--;
+      }
+      if (i >= 0) {
+        entries = entries.mid(i);
+      } else {
+        // not stored, e.g. after a partial download. don't pass the whole
+        // stored history off as the recent log.
+        entries = entries.mid(entries.size() - numNewEntries);
+        notice = "[Most recent power up event not in the log store, showing the events downloaded now]";
+      }
+    }
   }
-  // fetch logs
-  do {
-    responseList = iface->queryPmu(QStringList() << QString("K%1").arg(toHexNum(startIndex, 2)));
-    if (responseList.at(0).startsWith("ERROR")) {
-      // exit on error
-      log << responseList.at(0);
-      return log;
-    } else {
-      logSegment = parse_log(startIndex, responseList.at(0));
-      endTag = logSegment.takeLast();
-      log << logSegment;
-      startIndex += logSegment.length();
+  log = eventLog::format(entries);
+  if (!notice.isEmpty()) {
+    log.prepend(notice);
+  }
+  if (!error.isEmpty()) {
+    // keep what was downloaded and report the error
+    log << error;
+  } else {
+    log << "+[End of log]";
+  }
+  return log;
+}
+
+// brings the log store up to date and reads the fixture's clock and uptime
+// together, so the stored log can be placed on a site wide timeline
+QStringList sync_log(QStringList argList, interface *iface) {
+  bool ok[2];
+  logIndex_t logIndex;
+  int numNewEntries;
+  (void) argList;
+  QStringList responseList = iface->queryPmu(QStringList() << QString("K"));
+  if (responseList.at(0).startsWith("ERROR")) {
+    return responseList;
+  }
+  if (!eventLog::parseIndex(responseList.at(0), &logIndex)) {
+    return QStringList() << "ERROR: Malformed log index";
+  }
+  quint32 serialNumber = fixtureSerialNumber(iface);
+  if (serialNumber == 0) {
+    return QStringList() << "ERROR: Could not read the serial number of the fixture";
+  }
+  logStore store(serialNumber);
+  if (!store.load()) {
+    return QStringList() << "ERROR: Could not read the log store";
+  }
+  QString error = store.sync(iface, logIndex, &numNewEntries);
+  if (!error.isEmpty()) {
+    return QStringList() << error;
+  }
+  logQuery::shared()->setEntries(serialNumber, store.entries());
+  // read after the sync, so every stored event happened before the reading
+  responseList = iface->queryPmu(QStringList() << "G0003" << "G000C");
+  quint32 unixTime = responseList.at(0).toUInt(&ok[0], 16);
+  quint32 uptime = responseList.at(1).toUInt(&ok[1], 16);
+  if (!ok[0] || !ok[1]) {
+    return QStringList() << QString("ERROR: Could not read the fixture's clock");
+  }
+  if (!store.saveAnchor(unixTime, uptime)) {
+    return QStringList() << "ERROR: Could not write the log store";
+  }
+  return QStringList() << QString("+Synced %1 new events").arg(numNewEntries)
+                       << QString("+Fixture time: %1").arg(QDateTime::fromTime_t(unixTime).toString(Qt::ISODate));
+}
+
+// searches the logs downloaded by get log, of this fixture unless others
+// are named, e.g. query log type lightbar,battery from 1Y:20D limit 50
+QStringList query_log(QStringList argList, interface *iface) {
+  logQueryFilter_t filter;
+  QString error;
+  QStringList log;
+  if (!logQuery::parseFilter(argList, &filter, &error)) {
+    return QStringList() << error;
+  }
+  if (filter.serialNumbers.isEmpty()) {
+    quint32 serialNumber = fixtureSerialNumber(iface);
+    if (serialNumber == 0) {
+      return QStringList() << "ERROR: Could not read the serial number of the fixture";
+    }
+    filter.serialNumbers << serialNumber;
+  }
+  // logs synced in an earlier session are read from the log store once
+  foreach (quint32 serialNumber, filter.serialNumbers) {
+    if (!logQuery::shared()->contains(serialNumber)) {
+      logStore store(serialNumber);
+      if (store.load()) {
+        logQuery::shared()->setEntries(serialNumber, store.entries());
+      }
+    }
+  }
+  QVector<logMatch_t> matches = logQuery::shared()->find(filter);
+  quint32 lastSerialNumber = 0;
+  foreach (const logMatch_t &match, matches) {
+    if ((filter.serialNumbers.length() > 1) && (match.serialNumber != lastSerialNumber)) {
+      log << QString("+[Fixture %1]").arg(interface::fixtureName(match.serialNumber));
+      lastSerialNumber = match.serialNumber;
     }
-  } while ((endTag != "+[End of log]") || (log.length() >= 20));
-  // append the end tag
-  log << endTag;
+    log << eventLog::format(match.entry);
+  }
+  log << QString("+[%1 events]").arg(matches.size());
   return log;
 }
 
@@ -2139,173 +1120,51 @@ QStringList insert_logEntry(QStringList argList, interface *iface) {
   return iface->queryPmu(QStringList() << QString("E%1").arg(argList.at(0)));
 }
 
+/*** register cache commands ***/
+QStringList get_cacheStats(QStringList argList, interface *iface) {
+  (void) argList;
+  quint64 hits = iface->cacheHits();
+  quint64 misses = iface->cacheMisses();
+  quint64 total = hits + misses;
+  return QStringList() << QString("+Hits: %1").arg(hits)
+                       << QString("+Misses: %1").arg(misses)
+                       << QString("+Hit rate: %1%").arg(total ? (100 * hits / total) : 0);
+}
+
+QStringList reset_cache(QStringList argList, interface *iface) {
+  (void) argList;
+  iface->clearCache();
+  return QStringList() << "OK";
+}
+
 cmdHelper::cmdHelper(QObject *parent) : QObject(parent) {
-  QStringList keywordList;
-  // get & set PMU register commands
-  m_cmdTable.insert("get firmwareVersion", &get_firmwareVersion);
-  m_cmdTable.insert("get productCode", get_productCode);
-  m_cmdTable.insert("set productCode", set_productCode);
-  m_cmdTable.insert("get serialNumber", get_serialNumber);
-  m_cmdTable.insert("set serialNumber", set_serialNumber);
-  m_cmdTable.insert("get unixTime", get_unixTime);
-  m_cmdTable.insert("set unixTime", set_unixTime);
-  m_cmdTable.insert("get temperature", get_temperature);
+  // get & set PMU register commands, generated from the register table
+  for (int i = 0; i < registerTable::count(); i++) {
+    const registerDescriptor_t *reg = registerTable::at(i);
+    if (reg->access & REG_READ) {
+      m_cmdTable.insert(QString("get %1").arg(reg->name), [reg](QStringList argList, interface *iface) {
+        return registerTable::read(reg, argList, iface);
+      });
+    }
+    if (reg->access & REG_WRITE) {
+      m_cmdTable.insert(QString("set %1").arg(reg->name), [reg](QStringList argList, interface *iface) {
+        return registerTable::write(reg, argList, iface);
+      });
+    }
+  }
+  // composite PMU register commands
   m_cmdTable.insert("get lightLevel", get_lightLevel);
-  m_cmdTable.insert("set lightManualLevel", set_lightManualLevel);
-  m_cmdTable.insert("set lightOverrideActiveLevel", set_lightOverrideActiveLevel);
-  m_cmdTable.insert("set lightOverrideInactiveLevel", set_lightOverrideInactiveLevel);
-  m_cmdTable.insert("get sensorDelayTime", get_sensorDelayTime);
-  m_cmdTable.insert("get sensorOverrideDelayTime", get_sensorOverrideDelayTime);
-  m_cmdTable.insert("set sensorOverrideDelayTime", set_sensorOverrideDelayTime);
-  m_cmdTable.insert("get upTime", get_upTime);
   m_cmdTable.insert("get usage", get_usage);
-  m_cmdTable.insert("get numLogEntries", get_numLogEntries);
   m_cmdTable.insert("get configCalibration", get_configCalibration);
-  m_cmdTable.insert("set configCalibrationP0", set_configCalibrationP0);
-  m_cmdTable.insert("set configCalibrationP1", set_configCalibrationP1);
-  m_cmdTable.insert("set configCalibrationP2", set_configCalibrationP2);
-  m_cmdTable.insert("set configCalibrationP3", set_configCalibrationP3);
-  m_cmdTable.insert("get buildTime", get_buildTime);
-  m_cmdTable.insert("set buildTime", set_buildTime);
-  m_cmdTable.insert("get sensorTimeoutCountdown", get_sensorTimeoutCountdown);
-  m_cmdTable.insert("get currentLightLevel", get_currentLightLevel);
-  m_cmdTable.insert("get safeMode", get_safeMode);
-  m_cmdTable.insert("get lightBarSelect", get_lightBarSelect);
-  m_cmdTable.insert("set lightBarSelect", set_lightBarSelect);
-  m_cmdTable.insert("get powerConsumption", get_powerConsumption);
-  m_cmdTable.insert("get wirelessDataAggregator", get_wirelessDataAggregator);
-  m_cmdTable.insert("set wirelessDataAggregator", set_wirelessDataAggregator);
-  m_cmdTable.insert("get resetUsageTimestamp", get_resetUsageTimestamp);
-  m_cmdTable.insert("get pwmPeriodRegister", get_pwmPeriodRegister);
-  m_cmdTable.insert("set pwmPeriodRegister", set_pwmPeriodRegister);
-  m_cmdTable.insert("get analogSensorValue", get_analogSensorValue);
-  m_cmdTable.insert("get analogReportingHysteresis", get_analogReportingHysteresis);
-  m_cmdTable.insert("get zone", get_zone);
-  m_cmdTable.insert("set zone", set_zone);
-  m_cmdTable.insert("get lightTemporaryActiveLevel", get_lightTemporaryActiveLevel);
-  m_cmdTable.insert("set lightTemporaryActiveLevel", set_lightTemporaryActiveLevel);
-  m_cmdTable.insert("get lightTemporaryInactiveLevel", get_lightTemporaryInactiveLevel);
-  m_cmdTable.insert("set lightTemporaryInactiveLevel", set_lightTemporaryInactiveLevel);
-  m_cmdTable.insert("get sensorTemporaryDelayTime", get_sensorTemporaryDelayTime);
-  m_cmdTable.insert("set sensorTemporaryDelayTime", set_sensorTemporaryDealyTime);
-  m_cmdTable.insert("get temporaryOverrideTimeout", get_temporaryOverrideTimeout);
-  m_cmdTable.insert("set temporaryOverrideTimeout", set_temporaryOverrideTiemout);
-  m_cmdTable.insert("get setRemoteState", get_setRemoteState);
-  m_cmdTable.insert("set setRemoteState", set_setRemoteState);
-  m_cmdTable.insert("get remoteSetDelayTime", get_remoteStateDelayTime);
-  m_cmdTable.insert("set remoteSetDelayTime", set_remoteStateDelayTime);
-  m_cmdTable.insert("get remoteSecondsCountdown", get_remoteSecondsCountdown);
-  m_cmdTable.insert("get minimumDimmingValue", get_minimumDimmingValue);
   m_cmdTable.insert("get powerCalibration", get_powerCalibration);
-  m_cmdTable.insert("set powerCalibrationA0", set_powerCalibrationA0);
-  m_cmdTable.insert("set powerCalibrationB0", set_powerCalibrationB0);
-  m_cmdTable.insert("set powerCalibrationC0", set_powerCalibrationC0);
-  m_cmdTable.insert("set powerCalibrationMA", set_powerCalibrationMA);
-  m_cmdTable.insert("set powerCalibrationMB", set_powerCalibrationMB);
-  m_cmdTable.insert("set powerCalibrationMC", set_powerCalibrationMC);
-  m_cmdTable.insert("set powerCalibrationPOff", set_powerCalibrationPOff);
-  m_cmdTable.insert("set powerCalibrationPOn", set_powerCalibrationPOn);
-  m_cmdTable.insert("set powerCalibrationT0", set_powerCalibrationT0);
-  m_cmdTable.insert("get powerEstimatorTemperatureOverride", get_powerEstimatorTemperatureOverride);
-  m_cmdTable.insert("set powerEstimatorTemperatureOverride", set_powerEstimatorTemperatureOverride);
-  m_cmdTable.insert("get cachedTemperatureValue", get_cachedTemperatureValue);
-  m_cmdTable.insert("get eepromSize", get_eepromSize);
-  m_cmdTable.insert("get hardwareRevision", get_hardwareRevision);
   m_cmdTable.insert("get wirelessConfig", get_wirelessConfig);
-  m_cmdTable.insert("set wirelessPanId", set_wirelessPanId);
-  m_cmdTable.insert("set wirelessChannelMask", set_wirelessChannelMask);
-  m_cmdTable.insert("set wirelessShortAddress", set_wirelessShortAddress);
-  m_cmdTable.insert("set wirelessRole", set_wirelessRole);
-  m_cmdTable.insert("set wirelessWatchdogHold", set_wirelessWatchdogHold);
-  m_cmdTable.insert("set wirelessWatchdogPeriod", set_wirelessWatchdogPeriod);
-  m_cmdTable.insert("set wirelessNetworkKey", set_wirelessNetworkKey);
-  m_cmdTable.insert("get firmwareCode", get_firmwareCode);
-  m_cmdTable.insert("get moduleFirmwareCode", get_moduleFirmwareCode);
   m_cmdTable.insert("get maxTemperature", get_maxTemperature);
   m_cmdTable.insert("get overTemperatureConfig", get_overTemperatureConfig);
-  m_cmdTable.insert("set overTemperatureThresholdLow", set_overTemperatureThresholdLow);
-  m_cmdTable.insert("set overTemperatureThresholdHigh", get_overTemperatureThresholdHigh);
-  m_cmdTable.insert("set overTemperatureDimmingLimit", set_overTemperatureDimmingLimit);
-  m_cmdTable.insert("get analogDimmingMode", get_analogDimmingMode);
-  m_cmdTable.insert("set analogDimmingMode", set_analogDimmingMode);
-  m_cmdTable.insert("get fixtureIdMode", get_fixtureIdMode);
-  m_cmdTable.insert("set fixtureIdMode", set_fixtureIdMode);
-  m_cmdTable.insert("get acFrequency", get_acFrequency);
-  m_cmdTable.insert("get sensorBits", get_sensorBits);
-  m_cmdTable.insert("get powerMeterCommand", get_powerMeterCommand);
-  m_cmdTable.insert("set powerMeterCommand", set_powerMeterCommand);
-  m_cmdTable.insert("get powerMeterRegister", get_powerMeterRegister);
-  m_cmdTable.insert("set powerMeterRegister", set_powerMeterRegister);
-  m_cmdTable.insert("get ambientTemperature", get_ambientTemperature);
-  m_cmdTable.insert("get lightSensorLevel", get_lightSensorLevel);
   m_cmdTable.insert("get sensorConfig", get_sensorConfig);
-  m_cmdTable.insert("set sensor0Timeout", set_sensor0Timeout);
-  m_cmdTable.insert("set sensor0Offset", set_sensor0Offset);
-  m_cmdTable.insert("set sensor1Timeout", set_sensor1Timeout);
-  m_cmdTable.insert("set sensor1Offset", set_sensor1Offset);
   m_cmdTable.insert("get analogDimmingConfig", get_analogDimmingConfig);
-  m_cmdTable.insert("set analogDimmingLowValue", set_analogDimmingLowValue);
-  m_cmdTable.insert("set analogDimmingHighValue", set_analogDimmingHighValue);
-  m_cmdTable.insert("set analogDimmingOffValue", set_analogDimmingOffValue);
-  m_cmdTable.insert("get powerMeasurementMode", get_powerMeasurementMode);
-  m_cmdTable.insert("set powerMeasurementMode", set_powerMeasurementMode);
-  m_cmdTable.insert("get externalPowerMeter", get_externalPowerMeter);
-  m_cmdTable.insert("set externalPowerMeter", set_externalPowerMeter);
-  m_cmdTable.insert("get ambientSensorValue", get_ambientSensorValue);
   m_cmdTable.insert("get ambientConfig", get_ambientConfig);
-  m_cmdTable.insert("set ambientActiveLevel", set_ambientActiveLevel);
-  m_cmdTable.insert("set ambientInactiveLevel", set_ambientInactiveLevel);
-  m_cmdTable.insert("set ambientEnvironmentalGain", set_ambientEnvironmentalGain);
-  m_cmdTable.insert("set ambientOffHysteresis", set_ambientOffHysteresis);
-  m_cmdTable.insert("set ambientOnHysteresis", set_ambientOnHysteresis);
-  m_cmdTable.insert("get powerboardProtocol", get_powerboardProtocol);
-  m_cmdTable.insert("get ledOverride", get_ledOverride);
-  m_cmdTable.insert("set ledOverride", set_ledOverride);
-  m_cmdTable.insert("get fadeUpStep", get_fadeUpStep);
-  m_cmdTable.insert("set fadeUpStep", set_fadeUpStep);
-  m_cmdTable.insert("get fadeDownStep", get_fadeDownStep);
-  m_cmdTable.insert("set fadeDownStep", set_fadeDownStep);
-  m_cmdTable.insert("get maxBrightness", get_maxBrightness);
-  m_cmdTable.insert("set maxBrightness", set_maxBrightness);
-  m_cmdTable.insert("get i2cResets", get_i2cResets);
-  m_cmdTable.insert("get sensorGuardTime", get_sensorGuardTime);
-  m_cmdTable.insert("set sensorGuardTime", set_sensorGuardTime);
-  m_cmdTable.insert("get inputVoltage", get_inputVoltage);
-  m_cmdTable.insert("get inputVoltageCalibration", get_inputVoltageCalibration);
-  m_cmdTable.insert("set inputVoltageCalibration", set_inputVoltageCalibration);
-  m_cmdTable.insert("get numLightbars", get_numLightbars);
-  m_cmdTable.insert("set numLightbars", set_numLightbars);
-  m_cmdTable.insert("get currentLimit", get_currentLimit);
-  m_cmdTable.insert("set currentLimit", set_currentLimit);
-  m_cmdTable.insert("get bootloaderCode", get_bootloaderCode);
-  m_cmdTable.insert("get xpressMode", get_xpressMode);
-  m_cmdTable.insert("set xpressMode", set_xpressMode);
   m_cmdTable.insert("get batteryBackupStatus", get_batteryBackupStatus);
-  m_cmdTable.insert("set batteryBackupStatus", set_batteryBackupStatus);
-  m_cmdTable.insert("get sensorSeconds", get_sensorSeconds);
-  m_cmdTable.insert("get inputVoltageTwo", get_inputVoltageTwo);
-  m_cmdTable.insert("get inputVoltageTwoCalibration", get_inputVoltageTwoCalibration);
-  m_cmdTable.insert("set inputVoltageTwoCalibration", set_inputVoltageTwoCalibration);
-  m_cmdTable.insert("get maxRampUpSpeed", get_maxRampUpSpeed);
-  m_cmdTable.insert("set maxRampUpSpeed", set_maxRampUpSpeed);
-  m_cmdTable.insert("get maxRampDownSpeed", get_maxRampDownSpeed);
-  m_cmdTable.insert("set maxRampDownSpeed", set_maxRampDownSpeed);
-  m_cmdTable.insert("get emergencyLightLevel", get_emergencyLightLevel);
-  m_cmdTable.insert("get batteryBackupPowerCalibration", get_batteryBackupPowerCalibration);
-  m_cmdTable.insert("set batteryBackupPowerCalibration", set_batteryBackupPowerCalibration);
-  m_cmdTable.insert("get motionSensorProfile", get_motionSensorProfile);
-  m_cmdTable.insert("set motionSensorProfile", set_motionSensorProfile);
   m_cmdTable.insert("get powerMeterConfig", get_powerMeterConfig);
-  m_cmdTable.insert("set powerMeterLevelAtOff", set_powerMeterLevelAtOff);
-  m_cmdTable.insert("set powerMeterLevelAtMin", set_powerMeterLevelAtMin);
-  m_cmdTable.insert("set powerMeterLevelAtMax", set_powerMeterLevelAtMax);
-  m_cmdTable.insert("set powerMeterType", set_powerMeterType);
-  m_cmdTable.insert("get DLAiSlaveMode", get_DLAiSlaveMode);
-  m_cmdTable.insert("set DLAiSlaveMode", set_DLAiSlaveMode);
-  m_cmdTable.insert("get DALIBootloadingActive", get_DALIBootlodingActive);
-  m_cmdTable.insert("get testingMode", get_testingMode);
-  m_cmdTable.insert("set testingMode", set_testingMode);
-  m_cmdTable.insert("get numBatteriesSupported", get_numBatteriesSupported);
   // get & set lightbar commands
   m_cmdTable.insert("get lbVersion", get_lbVersion);
   m_cmdTable.insert("get lbStatus", get_lbStatus);
@@ -2339,11 +1198,24 @@ cmdHelper::cmdHelper(QObject *parent) : QObject(parent) {
   m_cmdTable.insert("reload motionSensorFirmware", reload_motionSensorFirmware);
   // log commands
   m_cmdTable.insert("get log", get_log);
+  m_cmdTable.insert("query log", query_log);
+  m_cmdTable.insert("sync log", sync_log);
   m_cmdTable.insert("insert logEntry", insert_logEntry);
-  // build the dictionary of helper commands
-  m_cmdCompleter = new QCompleter(m_cmdTable.keys(), this);
-  m_cmdCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-  m_cmdCompleter->setCompletionMode(QCompleter::InlineCompletion);
+  // register cache commands
+  m_cmdTable.insert("get cacheStats", get_cacheStats);
+  m_cmdTable.insert("reset cache", reset_cache);
+  // the completer is only built when a command line asks for it
+  m_cmdCompleter = NULL;
+}
+
+QCompleter *cmdHelper::completer(void) {
+  if (m_cmdCompleter == NULL) {
+    // build the dictionary of helper commands
+    m_cmdCompleter = new QCompleter(m_cmdTable.keys(), this);
+    m_cmdCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+    m_cmdCompleter->setCompletionMode(QCompleter::InlineCompletion);
+  }
+  return m_cmdCompleter;
 }
 
 cmdHandler_t cmdHelper::getCmdHandler(QString request) {
@@ -2354,32 +1226,75 @@ cmdHandler_t cmdHelper::getCmdHandler(QString request) {
   // verb object [optional argList]
   // example: set serialNumber 12345678
   if (argv.length() < 2) {
-    return NULL;
+    return cmdHandler_t();
   }
   cmd = QString("%1 %2").arg(argv.at(0)).arg(argv.at(1));
-  return m_cmdTable[cmd];
+  return m_cmdTable.value(cmd);
+}
+
+// splits a user request into its helper and arguments. raw PMU commands get
+// an empty handler and the command itself as the only argument.
+cmdHandler_t cmdHelper::parseRequest(QString request, QStringList *argList, bool *useCache) {
+  // --no-cache forces every register to be read from the fixture
+  *useCache = true;
+  if (request.contains(" --no-cache")) {
+    request.remove(" --no-cache");
+    *useCache = false;
+  }
+  cmdHandler_t handler = getCmdHandler(request);
+  if (!handler) {
+    *argList = QStringList() << request;
+  } else {
+    *argList = request.split(" ");
+    argList->removeFirst();
+    argList->removeFirst();
+  }
+  return handler;
 }
 
 QString cmdHelper::getNextCompletion(void) {
-  m_cmdCompleter->setCurrentRow(m_cmdCompleter->currentRow() + 1);
-  return m_cmdCompleter->currentCompletion();
+  completer()->setCurrentRow(completer()->currentRow() + 1);
+  return completer()->currentCompletion();
 }
 
 int cmdHelper::getCurrentCompletionLength(void) {
-  return m_cmdCompleter->currentCompletion().length();
+  return completer()->currentCompletion().length();
 }
 
-QStringList cmdHelper::help(void) {
+QStringList cmdHelper::help(QString topic) {
+  if (topic == "registers") {
+    return QStringList() << "REGISTERS:" << registerTable::help();
+  } else if (topic == "query") {
+    return QStringList() << "QUERY LOG:"
+                         << "- searches the logs downloaded with get log, in this or an earlier session"
+                         << "- type <names or hex types>, e.g. type power,i2c"
+                         << QString("- event types: %1").arg(logQuery::eventTypeNames().join(", "))
+                         << "- from <uptime> and to <uptime>, e.g. from 1Y:2D:3H"
+                         << "- fixture <serial numbers>, defaults to the connected fixture"
+                         << "- limit <n> keeps the most recent n events per fixture";
+  }
   return QStringList() << "COMMAND VERBS:"
                        << "- get, set, reset, reboot, reload"
                        << "REGISTER MODIFIERS:"
                        << "- lb (lightBar), bb (batteryBackup)"
                        << "EXAMPLES:"
                        << "- get firmwareVersion"
+                       << "- get serialNumber --no-cache"
                        << "- set serialNumber 04FACE15"
                        << "- reset network"
                        << "- reboot i2cDevices"
                        << "- reload lightbarFirmware"
                        << "- get bbVersion"
-                       << "- get lbConfig";
+                       << "- get lbConfig"
+                       << "- get log resume"
+                       << "- get log all"
+                       << "- query log type lightbar,battery from 1Y:20D to 1Y:30D"
+                       << "- sync log"
+                       << "- watch 2 get temperature"
+                       << "- watch stop"
+                       << "- record start"
+                       << "- record stop"
+                       << "MORE HELP:"
+                       << "- help registers"
+                       << "- help query";
 }
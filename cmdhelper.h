@@ -3,10 +3,16 @@
 
 #include <QObject>
 #include <QCompleter>
+#include <functional>
 
 class interface;
 
-typedef QStringList(*cmdHandler_t)(QStringList argList, interface *io);
+typedef std::function<QStringList(QStringList argList, interface *io)> cmdHandler_t;
+
+QString toYDHMS(QString timeInSec);
+QString toHexNum(int num, int size);
+QStringList parse_logIndex(QString response);
+QStringList parse_log(int startIndex, QString response);
 
 class cmdHelper : public QObject
 {
@@ -14,11 +20,12 @@ class cmdHelper : public QObject
 
 public:
   explicit cmdHelper(QObject *parent = 0);
-  QCompleter *m_cmdCompleter;
+  QCompleter *completer(void);
   cmdHandler_t getCmdHandler(QString request);
+  cmdHandler_t parseRequest(QString request, QStringList *argList, bool *useCache);
   QString getNextCompletion(void);
   int getCurrentCompletionLength(void);
-  QStringList help(void);
+  QStringList help(QString topic = QString());
 
 signals:
 
@@ -26,6 +33,7 @@ public slots:
 
 private:
   QHash <QString, cmdHandler_t> m_cmdTable;
+  QCompleter *m_cmdCompleter;
 };
 
 #endif // CMDHELPER_H
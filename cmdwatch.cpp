@@ -0,0 +1,148 @@
+#include "cmdwatch.h"
+#include "interface.h"
+
+// never poll faster than this, whatever the user asks for
+static const int s_minIntervalMs = 100;
+
+cmdWatch::cmdWatch(interface *iface, QObject *parent) : QObject(parent),
+  m_interface(iface),
+  m_active(false),
+  m_useCache(true),
+  m_requestedIntervalMs(0),
+  m_intervalMs(0),
+  m_nextSampleMs(0),
+  m_sentMs(0),
+  m_requestId(-1) {
+  m_timer.setSingleShot(true);
+  m_timer.setTimerType(Qt::PreciseTimer);
+  connect(&m_timer, SIGNAL(timeout()), this, SLOT(on_timeout()));
+  connect(m_interface, SIGNAL(requestFinished(int,QStringList)), this, SLOT(on_requestFinished(int,QStringList)));
+}
+
+// watch <seconds> <command>, where seconds may have a fraction
+bool cmdWatch::parseRequest(QString request, int *intervalMs, QString *command) {
+  bool ok;
+  if (request.section(' ', 0, 0) != "watch") {
+    return false;
+  }
+  double seconds = request.section(' ', 1, 1).toDouble(&ok);
+  *command = request.section(' ', 2);
+  if (!ok || (seconds <= 0) || command->isEmpty()) {
+    return false;
+  }
+  *intervalMs = qMax(s_minIntervalMs, qRound(seconds * 1000));
+  return true;
+}
+
+void cmdWatch::start(int intervalMs, cmdHandler_t handler, QStringList argList, bool useCache) {
+  stop();
+  m_handler = handler;
+  m_argList = argList;
+  m_useCache = useCache;
+  m_requestedIntervalMs = qMax(s_minIntervalMs, intervalMs);
+  m_intervalMs = m_requestedIntervalMs;
+  m_lastValues.clear();
+  m_active = true;
+  // the first sample goes out right away and prints everything
+  m_clock.start();
+  m_nextSampleMs = 0;
+  on_timeout();
+}
+
+void cmdWatch::stop(void) {
+  m_active = false;
+  m_timer.stop();
+  // a reply that is still on its way is dropped
+  m_requestId = -1;
+}
+
+bool cmdWatch::isActive(void) {
+  return m_active;
+}
+
+int cmdWatch::intervalMs(void) {
+  return m_intervalMs;
+}
+
+void cmdWatch::on_timeout(void) {
+  if (!m_active) {
+    return;
+  }
+  m_sentMs = m_clock.elapsed();
+  m_requestId = m_interface->runAsync(m_handler, m_argList, m_useCache);
+}
+
+void cmdWatch::on_requestFinished(int requestId, QStringList responseList) {
+  if (!m_active || (requestId != m_requestId)) {
+    return;
+  }
+  m_requestId = -1;
+  adaptInterval(m_clock.elapsed() - m_sentMs);
+  QStringList changed = changedLines(responseList);
+  if (!changed.isEmpty()) {
+    emit sampleChanged(changed);
+  }
+  scheduleNextSample();
+}
+
+// backs off when a round trip doesn't fit in the interval and creeps back to
+// the requested interval once round trips are comfortably shorter again
+void cmdWatch::adaptInterval(qint64 roundTripMs) {
+  int intervalMs = m_intervalMs;
+  if (roundTripMs > m_intervalMs) {
+    // leave a quarter of headroom, in whole tenths of a second
+    intervalMs = (((roundTripMs * 5) / 4 + 99) / 100) * 100;
+  } else if ((m_intervalMs > m_requestedIntervalMs) && ((roundTripMs * 2) < m_intervalMs)) {
+    intervalMs = qMax(m_requestedIntervalMs, (((m_intervalMs * 3) / 4 + 99) / 100) * 100);
+  }
+  if (intervalMs != m_intervalMs) {
+    m_intervalMs = intervalMs;
+    emit intervalChanged(m_intervalMs);
+  }
+}
+
+void cmdWatch::scheduleNextSample(void) {
+  qint64 now = m_clock.elapsed();
+  m_nextSampleMs += m_intervalMs;
+  if (m_nextSampleMs <= now) {
+    // skip the samples we missed instead of firing them all at once
+    m_nextSampleMs += (((now - m_nextSampleMs) / m_intervalMs) + 1) * m_intervalMs;
+  }
+  m_timer.start(m_nextSampleMs - now);
+}
+
+// a line is identified by its fixture and its "name:" prefix, or by its
+// position if it doesn't have one, like the reply to a raw command
+QStringList cmdWatch::changedLines(QStringList responseList) {
+  QStringList changed;
+  QString fixture;
+  bool fixturePrinted = false;
+  int position = 0;
+  foreach (const QString &response, responseList) {
+    if (response.startsWith("+[Fixture")) {
+      fixture = response;
+      fixturePrinted = false;
+      position = 0;
+      continue;
+    }
+    // helpers put several lines in one response
+    foreach (QString line, response.split("<br>", QString::SkipEmptyParts)) {
+      if (response.startsWith("+") && !line.startsWith("+")) {
+        line.prepend("+");
+      }
+      int separator = line.indexOf(": ");
+      QString key = fixture + "|" + ((separator > 0) ? line.left(separator) : QString("#%1").arg(position));
+      position++;
+      if (m_lastValues.contains(key) && (m_lastValues.value(key) == line)) {
+        continue;
+      }
+      m_lastValues.insert(key, line);
+      if (!fixture.isEmpty() && !fixturePrinted) {
+        changed << fixture;
+        fixturePrinted = true;
+      }
+      changed << line;
+    }
+  }
+  return changed;
+}
@@ -0,0 +1,57 @@
+#ifndef CMDWATCH_H
+#define CMDWATCH_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include "cmdhelper.h"
+
+class interface;
+
+// re-runs a request on a fixed schedule and reports only what changed, e.g.
+// watch 2 get temperature
+class cmdWatch : public QObject
+{
+  Q_OBJECT
+public:
+  explicit cmdWatch(interface *iface, QObject *parent = 0);
+  static bool parseRequest(QString request, int *intervalMs, QString *command);
+  void start(int intervalMs, cmdHandler_t handler, QStringList argList, bool useCache = true);
+  void stop(void);
+  bool isActive(void);
+  int intervalMs(void);
+
+signals:
+  // the lines that differ from the previous sample, with their fixture
+  void sampleChanged(QStringList responseList);
+  // round trips took longer than the interval, or got fast again
+  void intervalChanged(int intervalMs);
+
+private slots:
+  void on_timeout(void);
+  void on_requestFinished(int requestId, QStringList responseList);
+
+private:
+  interface *m_interface;
+  bool m_active;
+  QTimer m_timer;
+  QElapsedTimer m_clock;
+  cmdHandler_t m_handler;
+  QStringList m_argList;
+  bool m_useCache;
+  // what was asked for, and what round trips currently allow
+  int m_requestedIntervalMs;
+  int m_intervalMs;
+  // samples are due at fixed times on m_clock, so late replies don't add up
+  qint64 m_nextSampleMs;
+  qint64 m_sentMs;
+  int m_requestId;
+  QHash<QString, QString> m_lastValues;
+  QStringList changedLines(QStringList responseList);
+  void adaptInterval(qint64 roundTripMs);
+  void scheduleNextSample(void);
+};
+
+#endif // CMDWATCH_H
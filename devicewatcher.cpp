@@ -0,0 +1,78 @@
+#include "devicewatcher.h"
+#include <QDir>
+#include <QEventLoop>
+
+deviceWatcher::deviceWatcher(QString directory, QStringList nameFilters, QObject *parent) : QObject(parent),
+  m_directory(directory.isEmpty() ? QString("/dev") : directory),
+  m_nameFilters(nameFilters.isEmpty() ? defaultNameFilters() : nameFilters),
+  m_waitLoop(NULL),
+  m_changed(false) {
+  m_settleTimer.setSingleShot(true);
+  m_settleTimer.setInterval(20);
+  connect(&m_settleTimer, SIGNAL(timeout()), this, SLOT(scan()));
+  connect(&m_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(on_directoryChanged()));
+  m_watcher.addPath(m_directory);
+  m_devices = devices();
+}
+
+// FTDI and Silicon Labs adapters, as named by macOS and by Linux
+QStringList deviceWatcher::defaultNameFilters(void) {
+  return QStringList() << "cu.usbserial*" << "cu.SLAB_USBtoUART*" << "ttyUSB*" << "ttyACM*";
+}
+
+QString deviceWatcher::directory(void) const {
+  return m_directory;
+}
+
+// the matching devices present right now, sorted
+QStringList deviceWatcher::devices(void) const {
+  return QDir(m_directory).entryList(m_nameFilters, QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot, QDir::Name);
+}
+
+// runs the event loop until a device comes or goes, the timeout passes or
+// cancelWait() is called. returns whether a device came or went. the thread
+// sleeps in the meantime, it doesn't poll.
+bool deviceWatcher::waitForChange(int timeoutMs) {
+  QEventLoop loop;
+  m_waitLoop = &loop;
+  m_changed = false;
+  if (timeoutMs >= 0) {
+    QTimer::singleShot(timeoutMs, &loop, SLOT(quit()));
+  }
+  loop.exec();
+  m_waitLoop = NULL;
+  return m_changed;
+}
+
+void deviceWatcher::cancelWait(void) {
+  if (m_waitLoop) {
+    m_waitLoop->quit();
+  }
+}
+
+void deviceWatcher::on_directoryChanged(void) {
+  m_settleTimer.start();
+}
+
+void deviceWatcher::scan(void) {
+  QStringList devices = this->devices();
+  QStringList added;
+  QStringList removed;
+  foreach (const QString &device, devices) {
+    if (!m_devices.contains(device)) {
+      added << device;
+    }
+  }
+  foreach (const QString &device, m_devices) {
+    if (!devices.contains(device)) {
+      removed << device;
+    }
+  }
+  m_devices = devices;
+  if (added.isEmpty() && removed.isEmpty()) {
+    return;
+  }
+  m_changed = true;
+  emit devicesChanged(added, removed);
+  cancelWait();
+}
@@ -0,0 +1,46 @@
+#ifndef DEVICEWATCHER_H
+#define DEVICEWATCHER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+class QEventLoop;
+
+// tells when USB serial devices are plugged in or pulled out, by watching
+// the device directory (/dev) for nodes matching the name filters. nothing
+// runs while nothing changes. the directory is a parameter so a temporary
+// folder of plain files can stand in for /dev.
+class deviceWatcher : public QObject
+{
+  Q_OBJECT
+public:
+  explicit deviceWatcher(QString directory = QString(), QStringList nameFilters = QStringList(), QObject *parent = 0);
+  QString directory(void) const;
+  QStringList devices(void) const;
+  bool waitForChange(int timeoutMs = -1);
+  static QStringList defaultNameFilters(void);
+
+signals:
+  void devicesChanged(QStringList added, QStringList removed);
+
+public slots:
+  void cancelWait(void);
+
+private slots:
+  void on_directoryChanged(void);
+  void scan(void);
+
+private:
+  QFileSystemWatcher m_watcher;
+  // coalesces the burst of changes a single plug-in makes
+  QTimer m_settleTimer;
+  QString m_directory;
+  QStringList m_nameFilters;
+  QStringList m_devices;
+  QEventLoop *m_waitLoop;
+  bool m_changed;
+};
+
+#endif // DEVICEWATCHER_H
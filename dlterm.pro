@@ -1,34 +1,66 @@
 REQUIRED_QT = 5.5.0
 APPLICATION_VERSION = 0.4.0
 
-QT       += core gui network xml
+QT       += core gui network xml concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = dlterm
 TEMPLATE = app
 
+CONFIG += c++11
+
 
 SOURCES += main.cpp\
     mainwindow.cpp \
     cmdhelper.cpp \
     cmdhistory.cpp \
+    cmdwatch.cpp \
     solarized.cpp \
     preferencesdialog.cpp \
     interface.cpp \
+    registertable.cpp \
+    eventlog.cpp \
+    logstore.cpp \
+    logquery.cpp \
+    logtimeline.cpp \
+    samplerecorder.cpp \
+    outputmodel.cpp \
+    outputindex.cpp \
+    sessionlog.cpp \
+    headless.cpp \
+    pmuemulator.cpp \
+    bench.cpp \
     bifurcationdialog.cpp \
     emberdialog.cpp \
-    globalgateway.cpp
+    globalgateway.cpp \
+    devicewatcher.cpp \
+    joincache.cpp
 
 HEADERS  += mainwindow.h \
     cmdhelper.h \
     cmdhistory.h \
+    cmdwatch.h \
     solarized.h \
     preferencesdialog.h \
     interface.h \
+    registertable.h \
+    eventlog.h \
+    logstore.h \
+    logquery.h \
+    logtimeline.h \
+    samplerecorder.h \
+    outputmodel.h \
+    outputindex.h \
+    sessionlog.h \
+    headless.h \
+    pmuemulator.h \
+    bench.h \
     bifurcationdialog.h \
     emberdialog.h \
-    globalgateway.h
+    globalgateway.h \
+    devicewatcher.h \
+    joincache.h
 
 FORMS    += mainwindow.ui \
     preferencesdialog.ui \
@@ -67,6 +99,16 @@ macx {
     DESTDIR = $$join(DESTTYPE,,,-mac)
 }
 
+# make bench builds the app and prints the benchmark results as JSON
+macx {
+    BENCH_BINARY = $$OUT_PWD/$$DESTDIR/$${TARGET}.app/Contents/MacOS/$$TARGET
+} else {
+    BENCH_BINARY = $$OUT_PWD/$$DESTDIR/$$TARGET
+}
+bench.depends = first
+bench.commands = $$BENCH_BINARY --bench --json
+QMAKE_EXTRA_TARGETS += bench
+
 OBJECTS_DIR = temp
 MOC_DIR = temp
 UI_DIR = temp
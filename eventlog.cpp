@@ -0,0 +1,347 @@
+#include "eventlog.h"
+#include "cmdhelper.h"
+#include "interface.h"
+
+/*** event tables, indexed by event value ***/
+static const char *const s_powerEvents[] = {
+  "Power down",
+  "Power up",
+  "Power restored",
+  "Power soft reset"
+};
+
+static const char *const s_activityStateTransitionEvents[] = {
+  "Fixture inactive",
+  "Sensor 0 active",
+  "Sensor 1 active",
+  "Sensor 0 & Sensor 1 active",
+  "Remote sensor active",
+  "Remote sensor & sensor 0 active",
+  "Remote sensor & sensor 1 active",
+  "Remote sensor, sensor 0, and sensor 1 active"
+};
+
+static const char *const s_batteryBackupEvents[] = {
+  "Power activated",
+  "Power deactivated",
+  "Power failure [battery disconnected]",
+  "Power failure [battery over temperature]",
+  "Power failure [lightbar current sourced from PSU, not battery]",
+  "Power failure [backup power voltage out of range]",
+  "Power failure [battery drained]",
+  "Power failure [unexpected lightbar pattern or pattern could not be verified]",
+  "Battery test started",
+  "Battery test stopped",
+  "Error [battery disconnected]",
+  "Error [charge temperature exceeded]",
+  "Last error cleared",
+  "Power failure [UL/CE mismatch]"
+};
+
+template <int N>
+static QString eventName(const char *const (&table)[N], quint8 valueSize, quint64 value) {
+  // only single byte values name an event
+  if ((valueSize != 1) || (value >= (quint64) N)) {
+    return QString();
+  }
+  return QString::fromLatin1(table[value]);
+}
+
+/*** decoding ***/
+static inline int hexNibble(ushort c) {
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  } else if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  } else if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+// reads the next numDigits hex digits, false when the response is short or malformed
+static inline bool readHex(const QChar *data, int length, int *pos, int numDigits, quint64 *value) {
+  quint64 result = 0;
+  if (*pos + numDigits > length) {
+    return false;
+  }
+  for (int i = 0; i < numDigits; i++) {
+    int nibble = hexNibble(data[*pos + i].unicode());
+    if (nibble < 0) {
+      return false;
+    }
+    result = (result << 4) | nibble;
+  }
+  *pos += numDigits;
+  *value = result;
+  return true;
+}
+
+// decodes a K<index> response in a single pass, appending to entries
+// returns false if the response ended in the middle of an entry
+bool eventLog::decode(const QString &response, int startIndex, QVector<logEntry_t> *entries, bool *isLastEntry) {
+  const QChar *data = response.constData();
+  int length = response.length();
+  int pos = 0;
+  int numEvents = 0;
+  quint32 baseTime = 0;
+  quint64 field;
+  *isLastEntry = false;
+  // an entry is at least 4 characters long
+  entries->reserve(entries->size() + (length / 4));
+  while (pos < length) {
+    logEntry_t entry;
+    int uptimeSize;
+    // most significant bit of uptime size is last entry indicator
+    if (!readHex(data, length, &pos, 1, &field)) {
+      return false;
+    }
+    *isLastEntry = (field & 0x8);
+    uptimeSize = field & 0x7;
+    if (!readHex(data, length, &pos, 1, &field) || (field > 8)) {
+      return false;
+    }
+    entry.valueSize = field;
+    if (!readHex(data, length, &pos, 2, &field)) {
+      return false;
+    }
+    entry.eventType = field;
+    if (!readHex(data, length, &pos, uptimeSize * 2, &field)) {
+      return false;
+    }
+    // compute uptime, 4 byte timestamps are absolute and the rest are deltas
+    if (uptimeSize == 4) {
+      baseTime = field;
+    } else {
+      baseTime += field;
+    }
+    entry.uptime = baseTime;
+    if (!readHex(data, length, &pos, entry.valueSize * 2, &entry.value)) {
+      return false;
+    }
+    entry.index = startIndex + numEvents;
+    numEvents++;
+    entries->append(entry);
+  }
+  return true;
+}
+
+// log indexes are 2 bytes wide and wrap around
+static inline int logIndexDelta(int from, int to) {
+  return qint16(quint16(to - from));
+}
+
+bool eventLog::parseIndex(const QString &response, logIndex_t *logIndex) {
+  bool headOk, tailOk, firstOk;
+  if (response.length() < 12) {
+    return false;
+  }
+  logIndex->head = response.mid(0, 4).toInt(&headOk, 16);
+  logIndex->tail = response.mid(4, 4).toInt(&tailOk, 16);
+  logIndex->first = response.mid(8, 4).toInt(&firstOk, 16);
+  if (logIndex->first == 0xFFFF) {
+    logIndex->first = -1;
+  }
+  return headOk && tailOk && firstOk;
+}
+
+// downloads the log from startIndex up to endIndex (the tail) or the entry
+// flagged as the last one. each K<index> segment holds a variable number of
+// entries, so once the first one has arrived the segments that should follow
+// are requested up to pipelineDepth() at a time, assuming each holds at least
+// as many entries as the smallest segment seen so far. overlaps are dropped
+// and a gap is simply requested again in the next round. returns an empty
+// string on success or the error, with nextIndex set to the first entry that
+// wasn't downloaded either way.
+QString eventLog::download(interface *iface, int startIndex, int endIndex, QVector<logEntry_t> *entries, int *nextIndex) {
+  int stride = 0;
+  bool isLastEntry = false;
+  *nextIndex = startIndex & 0xFFFF;
+  endIndex &= 0xFFFF;
+  while (!isLastEntry && (*nextIndex != endIndex)) {
+    QStringList cmdList;
+    QList<int> segmentStarts;
+    int remaining = quint16(endIndex - *nextIndex);
+    int window = (stride == 0) ? 1 : iface->pipelineDepth();
+    for (int i = 0; (i < window) && ((i * stride) < remaining); i++) {
+      segmentStarts << ((*nextIndex + (i * stride)) & 0xFFFF);
+      cmdList << QString("K%1").arg(toHexNum(segmentStarts.last(), 2));
+    }
+    QStringList responseList = iface->queryPmu(cmdList);
+    for (int i = 0; (i < responseList.length()) && !isLastEntry && (*nextIndex != endIndex); i++) {
+      QVector<logEntry_t> segment;
+      bool segmentEnds;
+      int overlap = -logIndexDelta(*nextIndex, segmentStarts.at(i));
+      if (overlap < 0) {
+        // the previous segment was shorter than expected
+        break;
+      }
+      if (responseList.at(i).startsWith("ERROR")) {
+        if (i == 0) {
+          return responseList.at(i);
+        }
+        // retry from nextIndex in the next round
+        break;
+      }
+      if (!decode(responseList.at(i), segmentStarts.at(i), &segment, &segmentEnds)) {
+        return "ERROR: Malformed log entry";
+      }
+      if ((i == 0) && segment.isEmpty()) {
+        // nothing more to read
+        return QString();
+      }
+      stride = (stride == 0) ? segment.size() : qMin(stride, segment.size());
+      for (int j = overlap; (j < segment.size()) && (*nextIndex != endIndex); j++) {
+        segment[j].index &= 0xFFFF;
+        entries->append(segment.at(j));
+        *nextIndex = (segment.at(j).index + 1) & 0xFFFF;
+      }
+      isLastEntry = segmentEnds && (overlap < segment.size());
+    }
+  }
+  return QString();
+}
+
+/*** formatting ***/
+static QString valueString(quint8 valueSize, quint64 value) {
+  if (valueSize == 0) {
+    return QString();
+  }
+  return QString::number(value, 16).toUpper().rightJustified(valueSize * 2, '0');
+}
+
+QString eventLog::describe(const logEntry_t &entry) {
+  switch (entry.eventType) {
+  case 0x00:
+    return eventName(s_powerEvents, entry.valueSize, entry.value);
+  case 0x01:
+    return eventName(s_activityStateTransitionEvents, entry.valueSize, entry.value);
+  case 0x02:
+    // type 2 events are not implemented
+    return QString("Type 2 event: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x03:
+    return QString("Sensor off: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x04:
+    // unspecified value
+    return "SerialNet watchdog tripped";
+  case 0x05:
+    return QString("Temperature state change: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x06:
+    return QString("Lightbar error: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x07:
+    return QString("RTC set event: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x08: {
+    // the top nibble of the value is the battery number
+    int batteryNumber = 0;
+    quint64 value = entry.value;
+    if (entry.valueSize > 0) {
+      int shift = (entry.valueSize * 8) - 4;
+      if ((value >> shift) & 0xF) {
+        value &= ~(Q_UINT64_C(0xF) << shift);
+        batteryNumber = 1;
+      }
+    }
+    return QString("Battery backup %1 event: %2").arg(batteryNumber).arg(eventName(s_batteryBackupEvents, entry.valueSize, value));
+  }
+  case 0x09:
+    return QString("I2C watchdog reset event: %1").arg(valueString(entry.valueSize, entry.value));
+  case 0x0A:
+    // unspecified value
+    return "Registers restored from backup";
+  case 0x0B:
+    return QString("Ember reset reason: %1").arg(valueString(entry.valueSize, entry.value));
+  default:
+    // unknown event
+    return QString("Type %1 event: %2").arg(toHexNum(entry.eventType, 1), valueString(entry.valueSize, entry.value));
+  }
+}
+
+QString eventLog::format(const logEntry_t &entry) {
+  return QString("+%1 %2 > %3").arg(toHexNum(entry.index, 2), uptimeString(entry.uptime), describe(entry));
+}
+
+QStringList eventLog::format(const QVector<logEntry_t> &entries) {
+  QStringList log;
+  log.reserve(entries.size());
+  foreach (const logEntry_t &entry, entries) {
+    log << format(entry);
+  }
+  return log;
+}
+
+// formats seconds as 1Y:2D:3H:4M:5S, leaving out empty fields
+QString eventLog::uptimeString(quint32 seconds) {
+  QString outTime;
+  if (seconds == 0) {
+    return "0S";
+  }
+  if (seconds / 31536000) {
+    outTime += QString("%1Y:").arg(seconds / 31536000);
+    seconds %= 31536000;
+  }
+  if (seconds / 86400) {
+    outTime += QString("%1D:").arg(seconds / 86400);
+    seconds %= 86400;
+  }
+  if (seconds / 3600) {
+    outTime += QString("%1H:").arg(seconds / 3600);
+    seconds %= 3600;
+  }
+  if (seconds / 60) {
+    outTime += QString("%1M:").arg(seconds / 60);
+    seconds %= 60;
+  }
+  if (seconds) {
+    outTime += QString("%1S").arg(seconds);
+  }
+  if (outTime.endsWith(":")) {
+    outTime.truncate(outTime.length() - 1);
+  }
+  return outTime;
+}
+
+// the reverse of uptimeString, also taking lower case, no colons or plain seconds
+bool eventLog::parseUptime(QString text, quint32 *seconds) {
+  quint64 total = 0;
+  quint64 number = 0;
+  bool hasDigits = false;
+  text = text.toUpper().remove(':');
+  if (text.isEmpty()) {
+    return false;
+  }
+  foreach (QChar c, text) {
+    if (c.isDigit()) {
+      number = (number * 10) + c.digitValue();
+      hasDigits = true;
+      if (number > 0xFFFFFFFF) {
+        return false;
+      }
+      continue;
+    }
+    if (!hasDigits) {
+      return false;
+    }
+    if (c == 'Y') {
+      total += number * 31536000;
+    } else if (c == 'D') {
+      total += number * 86400;
+    } else if (c == 'H') {
+      total += number * 3600;
+    } else if (c == 'M') {
+      total += number * 60;
+    } else if (c == 'S') {
+      total += number;
+    } else {
+      return false;
+    }
+    number = 0;
+    hasDigits = false;
+  }
+  // trailing digits without a unit are seconds
+  total += number;
+  if (total > 0xFFFFFFFF) {
+    return false;
+  }
+  *seconds = total;
+  return true;
+}
@@ -0,0 +1,43 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// one decoded entry of a K<index> log segment
+struct logEntry_t {
+  // absolute log index of this entry
+  int index;
+  // seconds of uptime, with relative timestamps already resolved
+  quint32 uptime;
+  quint8 eventType;
+  // size of the event value in bytes (0-8)
+  quint8 valueSize;
+  quint64 value;
+};
+
+// head, tail and first power up index reported by a plain K command
+struct logIndex_t {
+  int head;
+  int tail;
+  // -1 when there are no recent events
+  int first;
+};
+
+class interface;
+
+class eventLog
+{
+public:
+  static bool parseIndex(const QString &response, logIndex_t *logIndex);
+  static QString download(interface *iface, int startIndex, int endIndex, QVector<logEntry_t> *entries, int *nextIndex);
+  static bool decode(const QString &response, int startIndex, QVector<logEntry_t> *entries, bool *isLastEntry);
+  static QString describe(const logEntry_t &entry);
+  static QString format(const logEntry_t &entry);
+  static QStringList format(const QVector<logEntry_t> &entries);
+  static QString uptimeString(quint32 seconds);
+  static bool parseUptime(QString text, quint32 *seconds);
+};
+
+#endif // EVENTLOG_H
@@ -1,6 +1,7 @@
 #include "globalgateway.h"
 #include "bifurcationdialog.h"
 #include "emberdialog.h"
+#include "devicewatcher.h"
 
 #include <QCoreApplication>
 #include <QtWidgets>
@@ -20,6 +21,7 @@ GlobalGateway::GlobalGateway() :
     m_gw(NULL),
     m_parentWidget(NULL),
     m_emberDialog(NULL),
+    m_deviceWatcher(NULL),
     m_canceled(false),
     m_joinedAsCoordinator(false)
 {
@@ -47,8 +49,10 @@ EmberGateway* GlobalGateway::getGateway(QWidget *parentWidget, bool allowUI)
 void GlobalGateway::pollForEmberGateway(bool allowUI)
 {
     DiscoveryAgent da;
+    deviceWatcher watcher;
 
     m_canceled = false;
+    m_deviceWatcher = &watcher;
 
     while (m_gw == NULL && m_canceled == false) {
         // Find an Ember USB Wireless Adapter and join it to the network.
@@ -59,27 +63,41 @@ void GlobalGateway::pollForEmberGateway(bool allowUI)
         if (da.m_gatewayList.isEmpty()) {
             if (allowUI) {
                 showEmberDialog();
-                msSleepWithEvents(750);
+                // Sleep until an adapter is plugged in or the dialog is canceled.
+                // Rescan every 5 s anyway, in case the adapter's device name
+                // isn't one the watcher looks for.
+                watcher.waitForChange(5000);
             } else {
-                return; // someone else will handle ui and re-calling
+                break; // someone else will handle ui and re-calling
             }
         } else {
             Gateway *gw = da.m_gatewayList.takeFirst();
-            m_gw = qobject_cast<Gateway_USB_Ember *>(gw);
-            if (!m_gw) {
+            EmberGateway *emberGw = qobject_cast<Gateway_USB_Ember *>(gw);
+            if (!emberGw) {
                 delete gw; // If we found an old non-Ember stick, ignore it
             } else {
-                connect(m_gw, SIGNAL(sigUsbDisconnected()), this, SLOT(slot_gatewayDeleted()));
+                openGateway(emberGw);
+                {
+                    QMutexLocker locker(&m_poolLock);
+                    m_gw = emberGw;
+                }
+                // Queued, so the adapter is never deleted from inside one of its calls
+                connect(m_gw, SIGNAL(sigUsbDisconnected()), this, SLOT(slot_gatewayDeleted()), Qt::QueuedConnection);
                 dismissEmberDialog();
             }
         }
     }
+
+    m_deviceWatcher = NULL;
 }
 
 void GlobalGateway::slot_cancelDialog()
 {
     dismissEmberDialog();
     m_canceled = true;
+    if (m_deviceWatcher) {
+        m_deviceWatcher->cancelWait();
+    }
 }
 
 void GlobalGateway::showEmberDialog()
@@ -102,23 +120,168 @@ void GlobalGateway::dismissEmberDialog()
     }
 }
 
-void GlobalGateway::msSleepWithEvents(const int milliseconds)
-{
-    QTime t;
-    t.restart();
-    do {
-        QCoreApplication::processEvents();
-    } while (t.elapsed() < milliseconds);
-}
-
 void GlobalGateway::deleteGateway()
 {
     // Called on object deletion, but also called if
     // some gw method returns DLLIB_USB_DISCONNECTED
-    // so the consumer can re-call getGateway()
-    if (m_gw) {
-        delete m_gw;
+    // so the consumer can re-call getGateway().
+    // Calls in flight on other threads return first.
+    EmberGateway *gw;
+    QList<EmberGateway *> extraGateways;
+
+    {
+        QMutexLocker locker(&m_poolLock);
+        gw = m_gw;
         m_gw = NULL;
+        // The extra adapters are only used alongside the first one
+        extraGateways = m_extraGateways;
+        m_extraGateways.clear();
+    }
+
+    if (gw) {
+        closeGateway(gw);
+        delete gw;
+    }
+    foreach (EmberGateway *extraGw, extraGateways) {
+        closeGateway(extraGw);
+        delete extraGw;
+    }
+}
+
+void GlobalGateway::leaveAnyNetwork()
+{
+    QList<EmberGateway *> gateways;
+
+    {
+        QMutexLocker locker(&m_poolLock);
+        if (m_gw != NULL) {
+            gateways << m_gw;
+        }
+        gateways << m_extraGateways;
+    }
+
+    foreach (EmberGateway *gw, gateways) {
+        GatewayLocker locker(gw);
+        if (locker.isLocked()) {
+            gw->leaveNetwork();
+        }
+    }
+}
+
+// Opens more Ember USB Wireless Adapters next to the one getGateway()
+// returns, until there are maxGateways in all, and returns how many there
+// are. Adapters that are already open aren't discovered again.
+int GlobalGateway::discoverGateways(int maxGateways)
+{
+    DiscoveryAgent da;
+
+    if (m_gw == NULL) {
+        return 0;
+    }
+
+    if (gatewayCount() < maxGateways) {
+        da.discoverGateway_usbs();
+    }
+    while (!da.m_gatewayList.isEmpty()) {
+        Gateway *gw = da.m_gatewayList.takeFirst();
+        EmberGateway *emberGw = qobject_cast<Gateway_USB_Ember *>(gw);
+        if (!emberGw || gatewayCount() >= maxGateways) {
+            delete gw; // Old non-Ember sticks and ones we don't need
+            continue;
+        }
+        openGateway(emberGw);
+        connect(emberGw, SIGNAL(sigUsbDisconnected()), this, SLOT(slot_extraGatewayDeleted()), Qt::QueuedConnection);
+        QMutexLocker locker(&m_poolLock);
+        m_extraGateways << emberGw;
+    }
+
+    return gatewayCount();
+}
+
+int GlobalGateway::gatewayCount()
+{
+    QMutexLocker locker(&m_poolLock);
+    return (m_gw == NULL) ? 0 : 1 + m_extraGateways.count();
+}
+
+// Index 0 is the adapter getGateway() returns, NULL past the last one
+EmberGateway* GlobalGateway::gatewayAt(int index)
+{
+    QMutexLocker locker(&m_poolLock);
+    if (index == 0) {
+        return m_gw;
+    }
+
+    return m_extraGateways.value(index - 1, NULL);
+}
+
+// DLLib doesn't promise that an adapter can carry calls from several
+// threads at once, or that it matches each reply to the call that sent the
+// command. So every thread locks the adapter around its calls on it, and
+// one command at a time is out on each adapter.
+void GlobalGateway::openGateway(EmberGateway *gw)
+{
+    QMutexLocker locker(&m_poolLock);
+    m_ioLocks.insert(gw, QSharedPointer<QMutex>(new QMutex()));
+}
+
+// Waits for a call on the adapter from another thread to return, and
+// after that lockGateway() fails for it, so it can be deleted. Must not be
+// called from inside a call on the adapter.
+void GlobalGateway::closeGateway(Gateway *gw)
+{
+    QSharedPointer<QMutex> ioLock;
+
+    {
+        QMutexLocker locker(&m_poolLock);
+        ioLock = m_ioLocks.value(gw);
+    }
+    if (ioLock.isNull()) {
+        return;
+    }
+
+    ioLock->lock();
+    {
+        QMutexLocker locker(&m_poolLock);
+        m_ioLocks.remove(gw);
+    }
+    ioLock->unlock();
+}
+
+// Returns false, without locking, if the adapter isn't open (or NULL), or
+// was closed while waiting for the lock
+bool GlobalGateway::lockGateway(Gateway *gw)
+{
+    QSharedPointer<QMutex> ioLock;
+
+    {
+        QMutexLocker locker(&m_poolLock);
+        ioLock = m_ioLocks.value(gw);
+    }
+    if (ioLock.isNull()) {
+        return false;
+    }
+
+    ioLock->lock();
+    QMutexLocker locker(&m_poolLock);
+    if (m_ioLocks.value(gw) != ioLock) {
+        ioLock->unlock();
+        return false;
+    }
+
+    return true;
+}
+
+void GlobalGateway::unlockGateway(Gateway *gw)
+{
+    QSharedPointer<QMutex> ioLock;
+
+    {
+        QMutexLocker locker(&m_poolLock);
+        ioLock = m_ioLocks.value(gw);
+    }
+    if (!ioLock.isNull()) {
+        ioLock->unlock();
     }
 }
 
@@ -128,118 +291,111 @@ void GlobalGateway::slot_gatewayDeleted()
     deleteGateway();
 }
 
-DLResult GlobalGateway::joinNetwork(unsigned long long panid,
-                                    unsigned long chmask,
-                                    bool askToCoordinate,
-                                    bool allowCoordination,
-                                    bool handleBifurcation,
-                                    unsigned int hopCount,
-                                    bool coordinateImmediately)
+void GlobalGateway::slot_extraGatewayDeleted()
 {
-    DLResult result;
-    Q_ASSERT(m_gw);
+    EmberGateway *gw = NULL;
 
-    m_joinedAsCoordinator = false;
+    {
+        QMutexLocker locker(&m_poolLock);
+        foreach (EmberGateway *extraGw, m_extraGateways) {
+            if (static_cast<QObject *>(extraGw) == sender()) {
+                gw = extraGw;
+            }
+        }
+        if (!gw) {
+            return;
+        }
+        m_extraGateways.removeOne(gw);
+    }
 
-    if (!coordinateImmediately) {
-        for (int i = 1; i < 7; i++) {
+    closeGateway(gw);
 
-            DLDebug(100, DL_FUNC_INFO) << QString("Joining network %1: %2 as router: %3")
-                                            .arg(panid, 16, 16, QChar('0'))
-                                            .arg(chmask, 4, 16, QChar('0'))
-                                            .arg(i);
-            if (hopCount > 0) {
-                result = m_gw->joinNetworkWithHopCount(hopCount, Gateway::Role_Router, panid, chmask);
-            } else {
-                result = m_gw->joinNetwork(Gateway::Role_Router, panid, chmask);
-            }
+    DLDebug(100, DL_FUNC_INFO) << "Extra gateway was pulled out? Deleting.";
+    // Closed, so nothing is using it any more. Let users move their
+    // fixtures to another adapter before it's gone.
+    emit gatewayRemoved(gw);
+    gw->deleteLater();
+}
 
-            // One can fake a bifurcated result by enabling this line:
-            // result = DLLIB_BIFURCATED_NETWORK;
-
-            if (result == DLLIB_BIFURCATED_NETWORK) {
-                if (handleBifurcation) {
-                    QString selectedNetworkStr;
-                    EmberGateway *gw = getGateway(0);
-                    bool tryIt = askForBifurcatedJoin(gw, m_parentWidget, selectedNetworkStr);
-                    if (tryIt) {
-                        bool ok;
-                        QStringList splitStrList = selectedNetworkStr.split(QChar(','));
-                        unsigned short shortpanid = splitStrList[1].toUInt(&ok, 16);
-                        if (ok) {
-                            return tryBifurcatedJoin(m_gw, panid, chmask, shortpanid, hopCount);
-                        } else {
-                            DLDebug(1, DL_FUNC_INFO) << "Bug: Failed to convert BifurcationDialog str to short panid:" << selectedNetworkStr;
-                            return DLLIB_FAILURE;
-                        }
-                    } else {
-                        return result;
-                    }
-                } else {
-                    return result;
-                }
-            }
+// A single attempt to join as a router, safe to call from a worker thread.
+// Retries, bifurcation and deleting a pulled out gateway are left to the
+// caller. A shortpanid picks one half of a bifurcated
+// network, index the adapter of gatewayAt().
+DLResult GlobalGateway::joinAsRouter(unsigned long long panid,
+                                     unsigned long chmask,
+                                     unsigned int hopCount,
+                                     unsigned short shortpanid,
+                                     int index)
+{
+    DLResult result;
+    EmberGateway *gw = gatewayAt(index);
+    Q_ASSERT(gw);
 
-            // Check for Chris' short address 'Bnnn' bug:
-            if (result == DLLIB_SUCCESS) {
-                quint16 nodeid;
-                result = m_gw->ezspGetNodeId(nodeid);
-                if (result == DLLIB_SUCCESS) {
-                    if ((nodeid & 0xf000) == 0xb000) {
-                        DLDebug(100, DL_FUNC_INFO) << "Joined with Bnnn short address:" << QString("%1").arg(nodeid,4,16,QChar('0'));
-                        result = DLLIB_FAILURE;
-                    } else {
-                        DLDebug(900, DL_FUNC_INFO) << "Joined with short addr" << QString("%1").arg(nodeid,4,16,QChar('0'));
-                    }
-                } else {
-                    result = DLLIB_FAILURE;
-                }
-            }
+    GatewayLocker locker(gw);
+    if (!locker.isLocked()) {
+        return DLLIB_USB_DISCONNECTED; // Pulled out since
+    }
 
-            if (result == DLLIB_SUCCESS) {
-                return result;
-            }
-            else if (result == DLLIB_USB_DISCONNECTED) {
-                deleteGateway();
-                return result;
-            }
-        }
+    if (index == 0) {
+        m_joinedAsCoordinator = false;
     }
 
-    // Ask permission to try once as a coordinator.
-    if (allowCoordination) {
-        if (askToCoordinate) {
-            unsigned group, freq;
-            bool encrypted;
-            if (!LRNetwork::groupAndFreqFromPanidAndChmask(panid, chmask,
-                                                           &group, &freq, &encrypted)) {
-                return DLLIB_FAILURE;
-            }
-            QMessageBox::StandardButton response =
-                    allowWirelessCoordinationDialog(LRNetwork::nwidFromGroupAndFreq(group, freq, encrypted));
-            if (response == QMessageBox::No) {
-                DLDebug(100, DL_FUNC_INFO) << "User opted NOT to join as a coordinator";
-                return DLLIB_FAILURE;
-            }
-        }
+    if (shortpanid != 0) {
+        result = gw->joinNetworkWithShortPanId(Gateway::Role_Router, panid, chmask, shortpanid, hopCount);
+    } else if (hopCount > 0) {
+        result = gw->joinNetworkWithHopCount(hopCount, Gateway::Role_Router, panid, chmask);
+    } else {
+        result = gw->joinNetwork(Gateway::Role_Router, panid, chmask);
+    }
 
-        MSLEEP(250);
-        DLDebug(100, DL_FUNC_INFO) << QString("Joining network %1: %2 as coordinator")
-                                        .arg(panid, 16, 16, QChar('0'))
-                                        .arg(chmask, 4, 16, QChar('0'));
-        if (hopCount > 0) {
-            result = m_gw->joinNetworkWithHopCount(hopCount, Gateway::Role_Coordinator, panid, chmask);
+    // One can fake a bifurcated result by enabling this line:
+    // result = DLLIB_BIFURCATED_NETWORK;
+
+    // Check for Chris' short address 'Bnnn' bug:
+    if (result == DLLIB_SUCCESS) {
+        quint16 nodeid;
+        result = gw->ezspGetNodeId(nodeid);
+        if (result == DLLIB_SUCCESS) {
+            if ((nodeid & 0xf000) == 0xb000) {
+                DLDebug(100, DL_FUNC_INFO) << "Joined with Bnnn short address:" << QString("%1").arg(nodeid,4,16,QChar('0'));
+                result = DLLIB_FAILURE;
+            } else {
+                DLDebug(900, DL_FUNC_INFO) << "Joined with short addr" << QString("%1").arg(nodeid,4,16,QChar('0'));
+            }
         } else {
-            result = m_gw->joinNetwork(Gateway::Role_Coordinator, panid, chmask);
+            result = DLLIB_FAILURE;
         }
+    }
 
-        if (result == DLLIB_USB_DISCONNECTED) {
-            deleteGateway();
-            return result;
-        }
-        m_joinedAsCoordinator = true;
+    return result;
+}
 
-        MSLEEP(3000); // Sleep a bit to allow fixtures to join our new network
+// A single attempt to coordinate the network, safe to call from a worker
+// thread. Fixtures need a few seconds to join afterwards.
+DLResult GlobalGateway::joinAsCoordinator(unsigned long long panid,
+                                          unsigned long chmask,
+                                          unsigned int hopCount)
+{
+    DLResult result;
+    EmberGateway *gw = gatewayAt(0);
+    Q_ASSERT(gw);
+
+    GatewayLocker locker(gw);
+    if (!locker.isLocked()) {
+        return DLLIB_USB_DISCONNECTED; // Pulled out since
+    }
+
+    DLDebug(100, DL_FUNC_INFO) << QString("Joining network %1: %2 as coordinator")
+                                    .arg(panid, 16, 16, QChar('0'))
+                                    .arg(chmask, 4, 16, QChar('0'));
+    if (hopCount > 0) {
+        result = gw->joinNetworkWithHopCount(hopCount, Gateway::Role_Coordinator, panid, chmask);
+    } else {
+        result = gw->joinNetwork(Gateway::Role_Coordinator, panid, chmask);
+    }
+
+    if (result != DLLIB_USB_DISCONNECTED) {
+        m_joinedAsCoordinator = true;
     }
 
     return result;
@@ -273,7 +429,13 @@ bool GlobalGateway::askForBifurcatedJoin(EmberGateway *gw, QWidget *parentWidget
     selectedNetworkStr.clear();
 
     QStringList networkList;
-    gw->getLastFoundNetworkList(networkList);
+    {
+        GatewayLocker locker(gw);
+        if (!locker.isLocked()) {
+            return false;
+        }
+        gw->getLastFoundNetworkList(networkList);
+    }
 
     // Add a fake entry: for TESTING ONLY
     // if (!networkList.isEmpty()) networkList << networkList.first().section(',',0,0) + ",dead";
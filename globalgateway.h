@@ -3,10 +3,15 @@
 
 #include "dllib.h"
 #include <QObject>
+#include <QList>
 #include <QMessageBox>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
 #include <QTimer>
 
 class Gateway_USB_Ember;
+class deviceWatcher;
 class EmberDialog;
 class QWidget;
 
@@ -22,16 +27,25 @@ public:
 
     EmberGateway* getGateway(QWidget *parent, bool allowUI = true);
     bool exists() { return m_gw != NULL; }
-    void leaveAnyNetwork() { if (m_gw != NULL) m_gw->leaveNetwork(); }
+    void leaveAnyNetwork();
     void deleteGateway();
 
-    DLResult joinNetwork(unsigned long long panid,
-                         unsigned long chmask,
-                         bool askToCoordinate = true,
-                         bool allowCoordination = true,
-                         bool handleBifurcation = true,
-                         unsigned int hopCount = 0,
-                         bool coordinateImmediately = false);
+    int discoverGateways(int maxGateways);
+    int gatewayCount();
+    EmberGateway* gatewayAt(int index);
+
+    bool lockGateway(Gateway *gw);
+    void unlockGateway(Gateway *gw);
+
+    DLResult joinAsRouter(unsigned long long panid,
+                          unsigned long chmask,
+                          unsigned int hopCount = 0,
+                          unsigned short shortpanid = 0,
+                          int index = 0);
+
+    DLResult joinAsCoordinator(unsigned long long panid,
+                               unsigned long chmask,
+                               unsigned int hopCount = 0);
 
     QMessageBox::StandardButton allowWirelessCoordinationDialog(QString nwid);
 
@@ -45,22 +59,62 @@ public:
                                         unsigned short shortpanid,
                                         unsigned int hopCount = 0);
 
+signals:
+    void gatewayRemoved(Gateway *gw);
+
 public slots:
     void slot_cancelDialog();
     void slot_gatewayDeleted();
+    void slot_extraGatewayDeleted();
 
 private:
     EmberGateway       *m_gw;
     QTimer              m_gwTimer;
     QWidget            *m_parentWidget;
     EmberDialog        *m_emberDialog;
+    deviceWatcher      *m_deviceWatcher;
+    // Adapters beyond m_gw, read by the threads that join them
+    QList<EmberGateway *> m_extraGateways;
+    QMutex              m_poolLock;
+    // One lock per open adapter, guarded by m_poolLock
+    QHash<Gateway *, QSharedPointer<QMutex> > m_ioLocks;
     bool                m_canceled;
     bool                m_joinedAsCoordinator;
 
     void pollForEmberGateway(bool allowUI = true);
+    void openGateway(EmberGateway *gw);
+    void closeGateway(Gateway *gw);
     void showEmberDialog();
     void dismissEmberDialog();
-    void msSleepWithEvents(const int milliseconds);
+};
+
+// Holds the lock of an adapter for as long as it's in scope, the way
+// QMutexLocker holds a mutex. isLocked() is false if the adapter was closed
+// before or while waiting for it, and the adapter must not be used then.
+class GatewayLocker
+{
+public:
+    explicit GatewayLocker(Gateway *gw) :
+        m_gw(gw),
+        m_locked(GlobalGateway::Instance()->lockGateway(gw))
+    {
+    }
+
+    ~GatewayLocker() { unlock(); }
+
+    bool isLocked() const { return m_locked; }
+
+    void unlock()
+    {
+        if (m_locked) {
+            GlobalGateway::Instance()->unlockGateway(m_gw);
+            m_locked = false;
+        }
+    }
+
+private:
+    Gateway *m_gw;
+    bool     m_locked;
 };
 
 #endif // GLOBALGATEWAY_H
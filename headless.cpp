@@ -0,0 +1,461 @@
+#include "headless.h"
+#include "cmdhelper.h"
+#include "interface.h"
+#include "samplerecorder.h"
+#include "logtimeline.h"
+#include "dllib.h"
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <cstdio>
+
+// quotes a CSV field if it needs it
+static QString csvField(QString field) {
+  if (field.contains(QRegExp("[\",\r\n]"))) {
+    field.replace("\"", "\"\"");
+    field = QString("\"%1\"").arg(field);
+  }
+  return field;
+}
+
+// reads a whole number option, false if it isn't one from min to max
+static bool numberOption(const QCommandLineParser &parser, const QCommandLineOption &option, int min, int max, int *value) {
+  bool ok;
+  *value = parser.value(option).toInt(&ok);
+  return ok && (*value >= min) && (*value <= max);
+}
+
+headlessRunner::headlessRunner(QObject *parent) : QObject(parent),
+  m_cmdHelper(new cmdHelper(this)),
+  m_interface(new interface(this)),
+  m_format(FORMAT_TEXT),
+  m_csvHeaderPrinted(false),
+  m_echo(false),
+  m_out(stdout, QIODevice::WriteOnly),
+  m_err(stderr, QIODevice::WriteOnly) {
+  // nobody is there to answer a dialog
+  m_interface->setInteractive(false);
+  connect(m_interface, SIGNAL(connectionStatusChanged(QString)), this, SLOT(on_connectionStatusChanged(QString)));
+}
+
+// checked before any application object exists, so the GUI never starts
+bool headlessRunner::isRequested(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    QString arg = QString::fromLocal8Bit(argv[i]);
+    if (arg.startsWith("--exec") || arg.startsWith("--script") || (arg == "-e") || (arg == "-s") ||
+        (arg == "--ftdi") || (arg == "--telegesis") || (arg == "--emulator") || (arg == "--sweep") ||
+        (arg == "--timeline") || arg.startsWith("--dump-samples") || (arg == "--help") || (arg == "-h")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int headlessRunner::run(QStringList arguments) {
+  QCommandLineParser parser;
+  QCommandLineOption helpOption = parser.addHelpOption();
+  QCommandLineOption ftdiOption("ftdi", "Connect to a PMU over USB.");
+  QCommandLineOption telegesisOption("telegesis", "Connect to fixtures through a USB Wireless Adapter.");
+  QCommandLineOption emulatorOption("emulator", "Talk to emulated fixtures instead of real ones.");
+  QCommandLineOption networkOption("network", "Wireless network, e.g. A01. Defaults to the factory network.", "nwid");
+  QCommandLineOption serialOption("serial", "Fixture serial numbers, e.g. 0400BEEF,0400BF00-0400BF0F.", "serials");
+  QCommandLineOption serialFileOption("serial-file", "Read more serial numbers from a file, # starts a comment.", "file");
+  QCommandLineOption execOption(QStringList() << "e" << "exec", "Run a command. Can be repeated.", "command");
+  QCommandLineOption scriptOption(QStringList() << "s" << "script", "Run the commands in a file, one per line. - reads stdin.", "file");
+  QCommandLineOption jsonOption("json", "Print one JSON object per command and fixture. Same as --format json.");
+  QCommandLineOption formatOption("format", "Output format: text, json or csv.", "format", "text");
+  QCommandLineOption sweepOption("sweep", "Run all commands on a fixture before moving on to the next, printing each fixture's results as soon as it's done.");
+  QCommandLineOption recordOption("record", "Record temperature, current level, power and input voltage reads to a directory.", "directory");
+  QCommandLineOption dumpSamplesOption("dump-samples", "Print a recorded sample file as CSV and exit.", "file");
+  QCommandLineOption timelineOption("timeline", "Sync the event logs of all fixtures and print them merged in wall clock order. "
+                                    "Without a connection, merges the logs synced earlier for --serial.");
+  QCommandLineOption concurrencyOption("concurrency", "Fixtures talked to at the same time.", "count", "8");
+  QCommandLineOption timeoutOption("timeout", "Seconds to wait for an FTDI connection.", "seconds", "30");
+  QCommandLineOption deviceDirOption("device-dir", "Watch this directory instead of /dev for USB adapters being plugged in.", "directory");
+  QCommandLineOption adaptersOption("adapters", "USB Wireless Adapters to spread the fixtures over.", "count", "1");
+  QCommandLineOption adapterNetworkOption("adapter-network", "Network of the next extra adapter, instead of --network. Can be repeated.", "nwid");
+  QCommandLineOption latencyOption("latency", "Emulated response time.", "ms", "0");
+  QCommandLineOption jitterOption("jitter", "Emulated random extra response time.", "ms", "0");
+  QCommandLineOption lossOption("loss", "Emulated percentage of lost commands.", "percent", "0");
+  QCommandLineOption seedOption("seed", "Seed for the emulated jitter, losses and event log.", "number", "1");
+  QStringList requests;
+  bool ok;
+  parser.setApplicationDescription("Digital Lumens Terminal, headless mode");
+  parser.addOption(ftdiOption);
+  parser.addOption(telegesisOption);
+  parser.addOption(emulatorOption);
+  parser.addOption(networkOption);
+  parser.addOption(serialOption);
+  parser.addOption(serialFileOption);
+  parser.addOption(execOption);
+  parser.addOption(scriptOption);
+  parser.addOption(jsonOption);
+  parser.addOption(formatOption);
+  parser.addOption(sweepOption);
+  parser.addOption(concurrencyOption);
+  parser.addOption(timelineOption);
+  parser.addOption(recordOption);
+  parser.addOption(dumpSamplesOption);
+  parser.addOption(timeoutOption);
+  parser.addOption(deviceDirOption);
+  parser.addOption(adaptersOption);
+  parser.addOption(adapterNetworkOption);
+  parser.addOption(latencyOption);
+  parser.addOption(jitterOption);
+  parser.addOption(lossOption);
+  parser.addOption(seedOption);
+  if (!parser.parse(arguments)) {
+    m_err << parser.errorText() << endl;
+    return EXIT_USAGE;
+  }
+  if (parser.isSet(helpOption)) {
+    m_out << parser.helpText();
+    return EXIT_OK;
+  }
+  if (parser.isSet(dumpSamplesOption)) {
+    return dumpSamples(parser.value(dumpSamplesOption));
+  }
+  int numConnections = parser.isSet(ftdiOption) + parser.isSet(telegesisOption) + parser.isSet(emulatorOption);
+  if ((numConnections > 1) || ((numConnections == 0) && !parser.isSet(timelineOption))) {
+    m_err << "Pick one of --ftdi, --telegesis or --emulator" << endl;
+    return EXIT_USAGE;
+  }
+  QString format = parser.isSet(jsonOption) ? QString("json") : parser.value(formatOption).toLower();
+  if (format == "json") {
+    m_format = FORMAT_JSON;
+  } else if (format == "csv") {
+    m_format = FORMAT_CSV;
+  } else if (format != "text") {
+    m_err << "--format expects text, json or csv" << endl;
+    return EXIT_USAGE;
+  }
+  // same ranges as in the preferences
+  int numAdapters;
+  int concurrency;
+  if (!numberOption(parser, adaptersOption, 1, 4, &numAdapters)) {
+    m_err << "--adapters expects 1 to 4 adapters" << endl;
+    return EXIT_USAGE;
+  }
+  if (!numberOption(parser, concurrencyOption, 1, 64, &concurrency)) {
+    m_err << "--concurrency expects 1 to 64 fixtures" << endl;
+    return EXIT_USAGE;
+  }
+  // at most a day, which still fits connectFTDI()'s milliseconds
+  int timeout;
+  if (!numberOption(parser, timeoutOption, 1, 86400, &timeout)) {
+    m_err << "--timeout expects 1 to 86400 seconds" << endl;
+    return EXIT_USAGE;
+  }
+  emulatorConfig_t config;
+  if (!numberOption(parser, latencyOption, 0, 60000, &config.latencyMs) ||
+      !numberOption(parser, jitterOption, 0, 60000, &config.jitterMs)) {
+    m_err << "--latency and --jitter expect 0 to 60000 ms" << endl;
+    return EXIT_USAGE;
+  }
+  if (!numberOption(parser, lossOption, 0, 100, &config.lossPercent)) {
+    m_err << "--loss expects 0 to 100 percent" << endl;
+    return EXIT_USAGE;
+  }
+  config.seed = parser.value(seedOption).toUInt(&ok);
+  if (!ok) {
+    m_err << "--seed expects a positive number" << endl;
+    return EXIT_USAGE;
+  }
+  // gather the commands, the ones given with --exec first
+  requests = parser.values(execOption);
+  if (parser.isSet(scriptOption)) {
+    QFile script;
+    QString path = parser.value(scriptOption);
+    if (path == "-") {
+      ok = script.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    } else {
+      script.setFileName(path);
+      ok = script.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!ok) {
+      m_err << QString("Could not read %1").arg(path) << endl;
+      return EXIT_NO_SCRIPT;
+    }
+    while (!script.atEnd()) {
+      // skip blank lines and # comments
+      QString line = QString::fromUtf8(script.readLine()).simplified();
+      if (!line.isEmpty() && !line.startsWith("#")) {
+        requests << line;
+      }
+    }
+  }
+  m_echo = (requests.length() > 1);
+  // sweeps list their fixtures in a file or on the command line
+  QString serials = parser.value(serialOption);
+  if (parser.isSet(serialFileOption)) {
+    QFile serialFile(parser.value(serialFileOption));
+    if (!serialFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      m_err << QString("Could not read %1").arg(serialFile.fileName()) << endl;
+      return EXIT_NO_SCRIPT;
+    }
+    while (!serialFile.atEnd()) {
+      serials += " " + QString::fromUtf8(serialFile.readLine()).section('#', 0, 0);
+    }
+  }
+  QList<quint32> serialNumbers;
+  if (numConnections == 0) {
+    // only merge what earlier syncs stored
+    serialNumbers = interface::parseSerialNumbers(serials, &ok);
+    if (!ok) {
+      m_err << "--timeline without a connection needs --serial with one or more serial numbers" << endl;
+      return EXIT_USAGE;
+    }
+    return runTimeline(serialNumbers, false) ? EXIT_OK : EXIT_COMMAND_ERROR;
+  }
+  // connect
+  if (parser.isSet(ftdiOption)) {
+    m_interface->setMaxConcurrentFixtures(concurrency);
+    m_interface->setDeviceDirectory(parser.value(deviceDirOption));
+    m_interface->connectFTDI(timeout * 1000);
+  } else {
+    // a single emulated fixture unless told otherwise
+    if (parser.isSet(emulatorOption) && serials.trimmed().isEmpty()) {
+      serials = "00000001";
+    }
+    serialNumbers = interface::parseSerialNumbers(serials, &ok);
+    if (!ok || serialNumbers.isEmpty()) {
+      m_err << QString("%1 needs --serial with one or more serial numbers").arg(parser.isSet(emulatorOption) ? "--emulator" : "--telegesis") << endl;
+      return EXIT_USAGE;
+    }
+    QString network = parser.isSet(networkOption) ? parser.value(networkOption).toUpper() : LRNetwork::s_FactoryDefaultNwidStr;
+    m_interface->configure(network, serialNumbers);
+    QStringList adapterNetworks;
+    foreach (const QString &adapterNetwork, parser.values(adapterNetworkOption)) {
+      adapterNetworks << adapterNetwork.toUpper();
+    }
+    m_interface->setGateways(qMax(numAdapters, 1 + adapterNetworks.length()), adapterNetworks);
+    // also bounds how many fixtures are verified at once while connecting
+    m_interface->setMaxConcurrentFixtures(concurrency);
+    if (parser.isSet(emulatorOption)) {
+      m_interface->connectEmulator(config);
+    } else {
+      m_interface->connectTelegesis();
+      m_interface->waitForConnection();
+    }
+  }
+  if (!m_interface->isConnected()) {
+    return EXIT_NO_CONNECTION;
+  }
+  sampleRecorder *recorder = NULL;
+  if (parser.isSet(recordOption)) {
+    recorder = new sampleRecorder(parser.value(recordOption));
+    m_interface->setRecorder(recorder);
+  }
+  // run every command, even after one of them failed
+  int result = EXIT_OK;
+  if (parser.isSet(ftdiOption)) {
+    // every PMU found on USB
+    serialNumbers = m_interface->fixtures();
+  }
+  if (parser.isSet(sweepOption)) {
+    if (!runSweep(serialNumbers, requests)) {
+      result = EXIT_COMMAND_ERROR;
+    }
+  } else {
+    foreach (QString request, requests) {
+      if (!runCommand(request)) {
+        result = EXIT_COMMAND_ERROR;
+      }
+    }
+  }
+  if (parser.isSet(timelineOption) && !runTimeline(serialNumbers, true)) {
+    result = EXIT_COMMAND_ERROR;
+  }
+  m_out.flush();
+  // writes out the samples that are still buffered
+  m_interface->setRecorder(NULL);
+  delete recorder;
+  m_interface->disconnect();
+  return result;
+}
+
+// returns false if any fixture responded with an error
+bool headlessRunner::runCommand(QString request) {
+  QStringList argList;
+  bool useCache;
+  bool ok = true;
+  if (request.startsWith("help")) {
+    printResult(request, QString(), m_cmdHelper->help(request.section(' ', 1, 1)));
+    return true;
+  }
+  cmdHandler_t handler = m_cmdHelper->parseRequest(request, &argList, &useCache);
+  QList<quint32> serialNumbers = m_interface->fixtures();
+  QMap<quint32, QStringList> results;
+  if (serialNumbers.length() > 1) {
+    // every fixture gets its own result
+    results = m_interface->queryFixtures(serialNumbers, handler, argList, useCache);
+  } else {
+    results.insert(serialNumbers.isEmpty() ? 0 : serialNumbers.first(), m_interface->run(handler, argList, useCache));
+  }
+  foreach (quint32 serialNumber, results.keys()) {
+    QString fixture = (serialNumbers.length() > 1) ? interface::fixtureName(serialNumber) : QString();
+    if (!printResult(request, fixture, results[serialNumber])) {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// runs all requests on each fixture, including the ones that couldn't be
+// connected to, so every fixture shows up in the results. returns false if any
+// fixture responded with an error.
+bool headlessRunner::runSweep(QList<quint32> serialNumbers, QStringList requests) {
+  QList<sweepRequest_t> sweepRequests;
+  QStringList sweepRequestStrings;
+  bool ok = true;
+  foreach (QString request, requests) {
+    if (request.startsWith("help")) {
+      printResult(request, QString(), m_cmdHelper->help(request.section(' ', 1, 1)));
+      continue;
+    }
+    sweepRequest_t sweepRequest;
+    sweepRequest.handler = m_cmdHelper->parseRequest(request, &sweepRequest.argList, &sweepRequest.useCache);
+    sweepRequests << sweepRequest;
+    sweepRequestStrings << request;
+  }
+  m_interface->sweep(serialNumbers, sweepRequests, [&](quint32 serialNumber, QList<QStringList> results) {
+    for (int i = 0; i < results.length(); i++) {
+      if (!printResult(sweepRequestStrings.at(i), interface::fixtureName(serialNumber), results.at(i))) {
+        ok = false;
+      }
+    }
+  });
+  return ok;
+}
+
+// syncs the logs of the fixtures if asked to and prints their events in
+// wall clock order. problems go to stderr, so stdout only has the timeline.
+// returns false if a fixture couldn't be synced or merged.
+bool headlessRunner::runTimeline(QList<quint32> serialNumbers, bool sync) {
+  QMap<quint32, QStringList> results;
+  bool ok = true;
+  if (sync) {
+    cmdHandler_t handler = m_cmdHelper->getCmdHandler("sync log");
+    results = m_interface->queryFixtures(serialNumbers, handler, QStringList());
+  }
+  logTimeline timeline;
+  foreach (quint32 serialNumber, serialNumbers) {
+    // a fixture that couldn't be synced still adds what was stored earlier
+    foreach (const QString &line, results.value(serialNumber)) {
+      if (line.contains("ERROR")) {
+        m_err << QString("[Fixture %1] %2").arg(interface::fixtureName(serialNumber), line) << endl;
+        ok = false;
+      }
+    }
+    QString error = timeline.addFixture(serialNumber);
+    if (!error.isEmpty()) {
+      m_err << QString("[Fixture %1] %2").arg(interface::fixtureName(serialNumber), error) << endl;
+      ok = false;
+    }
+  }
+  if (m_format == FORMAT_CSV) {
+    m_out << "time,fixture,index,event\n";
+  }
+  timelineEvent_t event;
+  while (timeline.next(&event)) {
+    QString time = QDateTime::fromMSecsSinceEpoch(event.time * 1000).toString(Qt::ISODate);
+    QString fixture = interface::fixtureName(event.serialNumber);
+    QString index = toHexNum(event.entry.index, 2);
+    QString description = eventLog::describe(event.entry);
+    if (m_format == FORMAT_JSON) {
+      QJsonObject object;
+      object.insert("time", time);
+      object.insert("fixture", fixture);
+      object.insert("index", index);
+      object.insert("event", description);
+      m_out << QJsonDocument(object).toJson(QJsonDocument::Compact) << "\n";
+    } else if (m_format == FORMAT_CSV) {
+      m_out << time << "," << fixture << "," << index << "," << csvField(description) << "\n";
+    } else {
+      m_out << QString("%1 %2 %3 > %4").arg(time, fixture, index, description) << "\n";
+    }
+  }
+  m_out.flush();
+  foreach (const QString &error, timeline.errors()) {
+    m_err << error << endl;
+    ok = false;
+  }
+  if (timeline.numSkipped() > 0) {
+    m_err << QString("[Skipped %1 events from uptimes the fixture's clock was never read in]").arg(timeline.numSkipped()) << endl;
+  }
+  return ok;
+}
+
+// one fixture,register,timestamp,value row per sample, values in hex like
+// the fixture reports them
+int headlessRunner::dumpSamples(QString path) {
+  QList<sampleSeries_t> seriesList;
+  if (!sampleRecorder::load(path, &seriesList)) {
+    m_err << QString("Could not read %1").arg(path) << endl;
+    return EXIT_NO_SCRIPT;
+  }
+  m_out << "fixture,register,timestamp,value\n";
+  foreach (const sampleSeries_t &series, seriesList) {
+    QString prefix = QString("%1,G%2,").arg(interface::fixtureName(series.serialNumber)).arg(toHexNum(series.address, 2));
+    for (int i = 0; i < series.timestamps.length(); i++) {
+      m_out << prefix << QDateTime::fromMSecsSinceEpoch(series.timestamps.at(i)).toString(Qt::ISODate) << ","
+            << QString::number(quint64(series.values.at(i)), 16).toUpper() << "\n";
+    }
+  }
+  m_out.flush();
+  return EXIT_OK;
+}
+
+// prints the result of a command and returns false if it contains an error
+bool headlessRunner::printResult(QString request, QString fixture, QStringList responseList) {
+  QStringList lines;
+  bool ok = true;
+  foreach (QString r, responseList) {
+    // parsed responses start with plus
+    if (r.startsWith("+")) {
+      r.remove(0, 1);
+    }
+    if (r.contains("ERROR")) {
+      ok = false;
+    }
+    lines << r.split("<br>", QString::SkipEmptyParts);
+  }
+  if (m_format == FORMAT_JSON) {
+    QJsonObject result;
+    result.insert("command", request);
+    if (!fixture.isEmpty()) {
+      result.insert("fixture", fixture);
+    }
+    result.insert("ok", ok);
+    result.insert("response", QJsonArray::fromStringList(lines));
+    m_out << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+  } else if (m_format == FORMAT_CSV) {
+    if (!m_csvHeaderPrinted) {
+      m_out << "fixture,command,ok,response\n";
+      m_csvHeaderPrinted = true;
+    }
+    m_out << csvField(fixture) << "," << csvField(request) << "," << (ok ? "true" : "false") << ","
+          << csvField(lines.join("\n")) << "\n";
+  } else {
+    if (m_echo) {
+      m_out << "> " << request << "\n";
+    }
+    if (!fixture.isEmpty()) {
+      m_out << QString("[Fixture %1]").arg(fixture) << "\n";
+    }
+    foreach (const QString &line, lines) {
+      m_out << line << "\n";
+    }
+  }
+  m_out.flush();
+  return ok;
+}
+
+void headlessRunner::on_connectionStatusChanged(QString status) {
+  // keep stdout for results
+  m_err << QString("[%1]").arg(status) << endl;
+}
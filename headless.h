@@ -0,0 +1,58 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+
+class cmdHelper;
+class interface;
+
+// runs commands from the command line or a script without any widgets, for
+// example: dlterm --ftdi --exec "get usage" --json
+class headlessRunner : public QObject
+{
+  Q_OBJECT
+public:
+  enum exitCode {
+    EXIT_OK = 0,
+    // bad or missing command line options
+    EXIT_USAGE = 1,
+    // no connection to a fixture could be established
+    EXIT_NO_CONNECTION = 2,
+    // at least one command returned an error
+    EXIT_COMMAND_ERROR = 3,
+    // the script file couldn't be read
+    EXIT_NO_SCRIPT = 4
+  };
+  enum outputFormat {
+    FORMAT_TEXT,
+    // one JSON object per line
+    FORMAT_JSON,
+    // fixture,command,ok,response with a header row
+    FORMAT_CSV
+  };
+  explicit headlessRunner(QObject *parent = 0);
+  static bool isRequested(int argc, char *argv[]);
+  int run(QStringList arguments);
+
+private slots:
+  void on_connectionStatusChanged(QString status);
+
+private:
+  cmdHelper *m_cmdHelper;
+  interface *m_interface;
+  outputFormat m_format;
+  bool m_csvHeaderPrinted;
+  // print each command before its result
+  bool m_echo;
+  QTextStream m_out;
+  QTextStream m_err;
+  bool runCommand(QString request);
+  bool runSweep(QList<quint32> serialNumbers, QStringList requests);
+  int dumpSamples(QString path);
+  bool runTimeline(QList<quint32> serialNumbers, bool sync);
+  bool printResult(QString request, QString fixture, QStringList responseList);
+};
+
+#endif // HEADLESS_H
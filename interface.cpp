@@ -1,39 +1,418 @@
 #include "interface.h"
 #include "dllib.h"
 #include "globalgateway.h"
-#include <QApplication>
+#include "devicewatcher.h"
+#include "samplerecorder.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QEventLoop>
+#include <QTime>
+#include <QFuture>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QThreadStorage>
+#include <QWaitCondition>
+#include <QtConcurrent>
+
+// state of the request running on the calling thread: the fixture addressed
+// by queryPmu(), only set while a fanned out request runs on one of the
+// fixture pool threads, and whether the register cache is bypassed.
+struct requestContext_t {
+  requestContext_t() : serialNumber(0), bypassCache(false) {}
+  quint32 serialNumber;
+  bool bypassCache;
+};
+static QThreadStorage<requestContext_t> s_requestContext;
+
+// reads in flight to an emulated fixture at once
+static const int s_pipelineDepth = 4;
 
 interface::interface(QObject *parent) : QObject(parent),
-  m_pmuRemote(NULL),
   m_pmuUSB(NULL),
+  m_discoveryAgent(NULL),
+  m_connectState(CONNECT_IDLE),
+  m_connectAttempt(0),
+  m_shortPanid(0),
+  m_hopCount(0),
+  m_usingCachedJoin(false),
+  m_hasNewJoin(false),
+  m_maxGateways(1),
   m_joined(false),
   m_connected(false),
-  m_closed(false) {
+  m_disconnecting(false),
+  m_verifyCanceled(false),
+  m_closed(false),
+  m_interactive(true),
+  m_nextRequestId(0),
+  m_cacheHits(0),
+  m_cacheMisses(0),
+  m_recorder(NULL) {
+  // emulated fixtures answer reads side by side, see queryPmu()
+  m_pipelinePool.setMaxThreadCount(s_pipelineDepth);
+  // all asynchronous requests run one after another on a single dedicated
+  // I/O thread, which is kept alive for the lifetime of the interface
+  m_ioPool.setMaxThreadCount(1);
+  m_ioPool.setExpiryTimeout(-1);
+  // requests fanned out to many fixtures share the gateway, a few at a time
+  m_fixturePool.setMaxThreadCount(8);
+  // connecting waits on these instead of sleeping
+  m_connectTimer.setSingleShot(true);
+  connect(&m_connectTimer, SIGNAL(timeout()), this, SLOT(on_connectTimeout()));
+  connect(&m_joinWatcher, SIGNAL(finished()), this, SLOT(on_joinFinished()));
+  connect(&m_poolWatcher, SIGNAL(finished()), this, SLOT(on_poolJoinFinished()));
+  connect(&m_verifyWatcher, SIGNAL(finished()), this, SLOT(on_verifyFinished()));
+  connect(&m_drainWatcher, SIGNAL(finished()), this, SLOT(on_ioDrained()));
+  connect(GlobalGateway::Instance(), SIGNAL(gatewayRemoved(Gateway*)), this, SLOT(on_gatewayRemoved(Gateway*)));
+  // registers that can't change while a session is open
+  setCachePolicy("G0000", CACHE_IMMUTABLE); // firmware version
+  setCachePolicy("G0001", CACHE_IMMUTABLE); // product code
+  setCachePolicy("G0002", CACHE_IMMUTABLE); // serial number
+  setCachePolicy("G0039", CACHE_IMMUTABLE); // eeprom size
+  setCachePolicy("G003A", CACHE_IMMUTABLE); // hardware revision
 }
 
 void interface::configure(QString networkStr, quint32 serialNumber) {
+  configure(networkStr, QList<quint32>() << serialNumber);
+}
+
+void interface::configure(QString networkStr, QList<quint32> serialNumbers) {
   m_networkStr = networkStr;
-  m_serialNumber = serialNumber;
+  m_serialNumbers = serialNumbers;
+}
+
+QList<quint32> interface::parseSerialNumbers(QString text, bool *ok) {
+  // accepts a list of hex serial numbers and ranges, e.g.
+  // 0400BEEF, 0400BF00-0400BF0F
+  QList<quint32> serialNumbers;
+  bool valid = true;
+  foreach (const QString &token, text.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts)) {
+    bool firstOk = false;
+    bool lastOk = true;
+    QStringList bounds = token.split('-');
+    quint32 first = bounds.at(0).toULong(&firstOk, 16);
+    quint32 last = first;
+    if (bounds.length() == 2) {
+      last = bounds.at(1).toULong(&lastOk, 16);
+    }
+    // refuse runaway ranges from a typo
+    if (!firstOk || !lastOk || (bounds.length() > 2) || (last < first) || ((last - first) >= 4096)) {
+      valid = false;
+      continue;
+    }
+    for (quint32 i = 0; i <= (last - first); i++) {
+      quint32 serialNumber = first + i;
+      if ((serialNumber != 0) && !serialNumbers.contains(serialNumber)) {
+        serialNumbers << serialNumber;
+      }
+    }
+  }
+  if (ok) {
+    *ok = valid && !serialNumbers.isEmpty();
+  }
+  return serialNumbers;
+}
+
+QString interface::fixtureName(quint32 serialNumber) {
+  return QString("%1").arg(serialNumber, 8, 16, QChar('0')).toUpper();
+}
+
+void interface::addFixture(quint32 serialNumber) {
+  unsigned short shortAddr = 0xBAAD;
+  QMutexLocker locker(&m_pmuRemotesLock);
+  if (m_pmuRemotes.contains(serialNumber)) {
+    return;
+  }
+  // create a fake PMU bound to the shared gateway
+  PMU_Remote *pmuRemote = new PMU_Remote(serialNumber, shortAddr);
+  pmuRemote->setGateway(GlobalGateway::Instance()->getGateway(0));
+  m_pmuRemotes.insert(serialNumber, pmuRemote);
+}
+
+void interface::removeFixture(quint32 serialNumber) {
+  PMU_Remote *pmuRemote;
+  Gateway *gw;
+  {
+    QMutexLocker locker(&m_pmuRemotesLock);
+    pmuRemote = m_pmuRemotes.take(serialNumber);
+    gw = m_fixtureGateways.contains(serialNumber) ? m_fixtureGateways.take(serialNumber) : GlobalGateway::Instance()->gatewayAt(0);
+  }
+  deleteRemote(pmuRemote, gw);
+}
+
+// deletes a remote that was taken out of m_pmuRemotes once a command that
+// another thread still has out to it through gw is answered
+void interface::deleteRemote(PMU_Remote *pmuRemote, Gateway *gw) {
+  GatewayLocker locker(gw);
+  delete pmuRemote;
+}
+
+void interface::removeAllFixtures(void) {
+  QList<QThreadPool *> usbPools;
+  QMap<quint32, PMU_Remote *> pmuRemotes;
+  QHash<quint32, EmberGateway *> fixtureGateways;
+  {
+    QMutexLocker locker(&m_pmuRemotesLock);
+    pmuRemotes.swap(m_pmuRemotes);
+    fixtureGateways.swap(m_fixtureGateways);
+    qDeleteAll(m_emulators);
+    m_emulators.clear();
+    usbPools = m_usbPools.values();
+    m_usbPools.clear();
+    m_pmuUSBs.clear();
+    m_pmuUSB = NULL;
+  }
+  foreach (quint32 serialNumber, pmuRemotes.keys()) {
+    Gateway *gw = fixtureGateways.contains(serialNumber) ? fixtureGateways.value(serialNumber) : GlobalGateway::Instance()->gatewayAt(0);
+    deleteRemote(pmuRemotes.value(serialNumber), gw);
+  }
+  // commands already handed to a PMU on USB finish first
+  foreach (QThreadPool *usbPool, usbPools) {
+    usbPool->waitForDone();
+    delete usbPool;
+  }
+}
+
+QList<quint32> interface::fixtures(void) {
+  QMutexLocker locker(&m_pmuRemotesLock);
+  if (!m_emulators.isEmpty()) {
+    return m_emulators.keys();
+  }
+  return m_pmuUSBs.isEmpty() ? m_pmuRemotes.keys() : m_pmuUSBs.keys();
+}
+
+PMU_Remote *interface::remoteFor(quint32 serialNumber) {
+  QMutexLocker locker(&m_pmuRemotesLock);
+  return m_pmuRemotes.value(serialNumber, NULL);
+}
+
+// the adapter the fixture answered through while connecting, the first
+// adapter if there is only one. never looks for an adapter, so it's safe
+// on worker threads.
+Gateway *interface::gatewayFor(quint32 serialNumber) {
+  {
+    QMutexLocker locker(&m_pmuRemotesLock);
+    if (m_fixtureGateways.contains(serialNumber)) {
+      return m_fixtureGateways.value(serialNumber);
+    }
+  }
+  return GlobalGateway::Instance()->gatewayAt(0);
+}
+
+// locks the fixture's adapter and returns it along with the fixture's
+// remote, or NULL if the fixture isn't connected. both are looked up once
+// the lock is held, so neither can be deleted under the caller. the
+// fixture may have moved to another adapter while waiting, then the new
+// one is locked instead.
+Gateway *interface::lockGatewayFor(quint32 serialNumber, PMU_Remote **pmuRemote) {
+  GlobalGateway *ggw = GlobalGateway::Instance();
+  for (int attempt = 0; attempt < 2; attempt++) {
+    Gateway *gw = gatewayFor(serialNumber);
+    if (!ggw->lockGateway(gw)) {
+      continue;
+    }
+    *pmuRemote = remoteFor(serialNumber);
+    if ((*pmuRemote != NULL) && (gatewayFor(serialNumber) == gw)) {
+      return gw;
+    }
+    ggw->unlockGateway(gw);
+  }
+  return NULL;
 }
 
-void interface::connectFTDI(void) {
+pmuEmulator *interface::emulatorFor(quint32 serialNumber) {
+  QMutexLocker locker(&m_pmuRemotesLock);
+  return m_emulators.value(serialNumber, NULL);
+}
+
+quint32 interface::currentFixture(void) {
+  if (s_requestContext.localData().serialNumber != 0) {
+    return s_requestContext.localData().serialNumber;
+  }
+  // outside of a fan out, talk to the first fixture of the session
+  QMutexLocker locker(&m_pmuRemotesLock);
+  if (!m_emulators.isEmpty()) {
+    return m_emulators.firstKey();
+  }
+  if (!m_pmuUSBs.isEmpty()) {
+    return m_pmuUSBs.firstKey();
+  }
+  return m_pmuRemotes.isEmpty() ? 0 : m_pmuRemotes.firstKey();
+}
+
+// 1 to 64 threads
+void interface::setMaxConcurrentFixtures(int maxFixtures) {
+  m_fixturePool.setMaxThreadCount(qBound(1, maxFixtures, 64));
+}
+
+QStringList interface::runOnFixture(quint32 serialNumber, cmdHandler_t handler, QStringList argList, bool useCache) {
+  QStringList responseList;
+  s_requestContext.localData().serialNumber = serialNumber;
+  s_requestContext.localData().bypassCache = !useCache;
+  if (!handler) {
+    responseList = queryPmu(argList);
+  } else {
+    responseList = handler(argList, this);
+  }
+  s_requestContext.setLocalData(requestContext_t());
+  return responseList;
+}
+
+// a few fixtures at a time, on m_fixturePool. fixtures behind the same
+// adapter take turns on its lock, see issueCommand(), so the fan out only
+// overlaps the work around each command and commands on different adapters.
+// a remote is only used by the thread holding its adapter's lock.
+QMap<quint32, QStringList> interface::queryFixtures(QList<quint32> serialNumbers, cmdHandler_t handler, QStringList argList, bool useCache) {
+  QMap<quint32, QFuture<QStringList> > inFlight;
+  QMap<quint32, QStringList> results;
+  foreach (quint32 serialNumber, serialNumbers) {
+    inFlight.insert(serialNumber, QtConcurrent::run(&m_fixturePool, this, &interface::runOnFixture, serialNumber, handler, argList, useCache));
+  }
+  foreach (quint32 serialNumber, inFlight.keys()) {
+    results.insert(serialNumber, inFlight[serialNumber].result());
+  }
+  return results;
+}
+
+QList<QStringList> interface::sweepFixture(quint32 serialNumber, QList<sweepRequest_t> requests) {
+  QList<QStringList> results;
+  foreach (const sweepRequest_t &request, requests) {
+    results << runOnFixture(serialNumber, request.handler, request.argList, request.useCache);
+  }
+  return results;
+}
+
+// runs every request on every fixture, at most setMaxConcurrentFixtures()
+// fixtures at a time. each fixture runs its requests in order. onFixtureDone
+// is called on the calling thread as soon as a fixture is done, so results
+// can be written out while the rest of the fixtures are still busy. fixtures
+// that aren't in the session answer every command with an error.
+void interface::sweep(QList<quint32> serialNumbers, QList<sweepRequest_t> requests, sweepCallback_t onFixtureDone) {
+  QMutex lock;
+  QWaitCondition fixtureDone;
+  QList<QPair<quint32, QList<QStringList> > > done;
+  int numPending = serialNumbers.length();
+  foreach (quint32 serialNumber, serialNumbers) {
+    QtConcurrent::run(&m_fixturePool, [=, &lock, &fixtureDone, &done]() {
+      QList<QStringList> results = sweepFixture(serialNumber, requests);
+      QMutexLocker locker(&lock);
+      done << qMakePair(serialNumber, results);
+      fixtureDone.wakeOne();
+    });
+  }
+  QMutexLocker locker(&lock);
+  while (numPending > 0) {
+    while (done.isEmpty()) {
+      fixtureDone.wait(&lock);
+    }
+    QPair<quint32, QList<QStringList> > next = done.takeFirst();
+    numPending--;
+    // let the workers keep going while the caller handles the results
+    locker.unlock();
+    onFixtureDone(next.first, next.second);
+    locker.relock();
+  }
+}
+
+// a non-interactive interface never opens a dialog: it doesn't wait for a
+// USB Wireless Adapter to be plugged in, never offers to join as a
+// coordinator and doesn't ask how to join a bifurcated network
+void interface::setInteractive(bool interactive) {
+  m_interactive = interactive;
+}
+
+// uses up to maxGateways USB Wireless Adapters. the first joins the
+// session's network, the others the ones in networks, in order, or the
+// session's network again, which spreads one site's fixtures over them.
+void interface::setGateways(int maxGateways, QStringList networks) {
+  m_maxGateways = qMax(1, maxGateways);
+  m_gatewayNetworks = networks;
+}
+
+// where connectFTDI() watches for adapters being plugged in, /dev by default
+void interface::setDeviceDirectory(QString directory) {
+  m_deviceDirectory = directory;
+}
+
+// looks for PMUs on USB until one shows up or timeoutMs (-1 to wait forever).
+// every PMU found in that pass becomes a fixture of the session.
+void interface::connectFTDI(int timeoutMs) {
+  QTime elapsed;
+  if (m_disconnecting) {
+    finishDisconnect();
+  }
+  finishCanceledVerify();
+  deviceWatcher watcher(m_deviceDirectory);
   m_discoveryAgent = new DiscoveryAgent();
   connect(m_discoveryAgent, SIGNAL(signalPMUDiscovered(PMU*)), this, SLOT(slotPMUDiscovered(PMU*)));
   Q_CHECK_PTR(m_discoveryAgent);
   m_discoveryAgent->clearLists();
-  do {
+  elapsed.start();
+  m_discoveryAgent->discoverPMU_usbs();
+  QCoreApplication::processEvents();
+  // look again only when a serial device comes or goes. D2XX adapters
+  // without a serial driver have no device node, so every few seconds
+  // discovery runs regardless.
+  while (m_discoveryAgent->m_pmuList.isEmpty() && ((timeoutMs < 0) || (elapsed.elapsed() < timeoutMs))) {
+    int waitMs = (timeoutMs < 0) ? 5000 : qMin(5000, timeoutMs - elapsed.elapsed());
+    watcher.waitForChange(qMax(0, waitMs));
     m_discoveryAgent->discoverPMU_usbs();
-    MSLEEP(500);
-    QApplication::processEvents();
-  } while (m_discoveryAgent->m_pmuList.isEmpty());
+    QCoreApplication::processEvents();
+  }
+  addUSBFixtures();
+  int numFixtures = fixtures().length();
+  if (m_pmuUSB == NULL) {
+    emit connectionStatusChanged("No FTDI connection found");
+    return;
+  } else if (numFixtures == 1) {
+    emit connectionStatusChanged(QString("FTDI connection established"));
+  } else {
+    emit connectionStatusChanged(QString("FTDI connection established to %1 fixtures").arg(numFixtures));
+  }
+  m_connected = true;
+  emit connectionEstablished();
 }
 
+// doesn't wait for the request running on the I/O thread. it and the ones
+// queued behind it fail at their next command, and the fixtures are let go
+// once they're done.
 void interface::disconnect(void) {
+  cancelConnect();
+  m_connected = false;
+  if (m_ioPool.activeThreadCount() == 0) {
+    finishDisconnect();
+    return;
+  }
+  m_canceling.store(1);
+  m_disconnecting = true;
+  emit connectionStatusChanged("Disconnecting, canceling pending requests");
+  // runs after every request already handed to the I/O thread
+  m_drainWatcher.setFuture(QtConcurrent::run(&m_ioPool, []() {}));
+}
+
+void interface::on_ioDrained(void) {
+  if (m_disconnecting) {
+    finishDisconnect();
+  }
+}
+
+// also called by the connect functions, in case they come before the I/O
+// thread is done with the canceled requests
+void interface::finishDisconnect(void) {
+  m_ioPool.waitForDone();
+  m_disconnecting = false;
+  m_verifyCanceled = false;
+  m_canceling.store(0);
+  // the discovery agent owns the PMUs on USB, so let go of them first
+  removeAllFixtures();
   if (m_discoveryAgent) {
     m_discoveryAgent->clearLists();
     delete m_discoveryAgent;
+    m_discoveryAgent = NULL;
   }
+  clearCache();
   GlobalGateway::Instance()->leaveAnyNetwork();
+  m_gateways.clear();
+  m_gatewayNetworkStrs.clear();
   m_connected = false;
   emit connectionStatusChanged("Disconnected");
 }
@@ -42,94 +421,626 @@ bool interface::isConnected(void) {
   return m_connected;
 }
 
+// 0 if the PMU doesn't answer
+static quint32 readSerialNumber(PMU_USB *pmuUSB) {
+  QString response;
+  bool ok = false;
+  if (pmuUSB->issueCommand("G0002", response, 5) != DLLIB_SUCCESS) {
+    return 0;
+  }
+  quint32 serialNumber = response.toUInt(&ok, 16);
+  return ok ? serialNumber : 0;
+}
+
+// every PMU on a USB cable becomes a fixture of the session, addressed by
+// its serial number and talked to from its own I/O thread. the serial
+// number is read on that thread too, addUSBFixtures() collects it.
 void interface::slotPMUDiscovered(PMU* pmu) {
-  m_pmuUSB = qobject_cast<PMU_USB*>(pmu);
-  if (!m_pmuUSB) {
-    m_connected = false;
+  PMU_USB *pmuUSB = qobject_cast<PMU_USB*>(pmu);
+  if (!pmuUSB) {
     return;
   }
-  m_connected = true;
-  emit connectionStatusChanged(QString("FTDI connection established"));
-  emit connectionEstablished();
+  foreach (const usbDiscovery_t &discovery, m_usbDiscoveries) {
+    if (discovery.pmuUSB == pmuUSB) {
+      return;
+    }
+  }
+  {
+    QMutexLocker locker(&m_pmuRemotesLock);
+    if (m_pmuUSBs.values().contains(pmuUSB)) {
+      return;
+    }
+  }
+  usbDiscovery_t discovery;
+  discovery.pmuUSB = pmuUSB;
+  discovery.usbPool = new QThreadPool(this);
+  discovery.usbPool->setMaxThreadCount(1);
+  discovery.usbPool->setExpiryTimeout(-1);
+  discovery.serialNumber = QtConcurrent::run(discovery.usbPool, readSerialNumber, pmuUSB);
+  m_usbDiscoveries << discovery;
 }
 
+// runs the event loop until the serial numbers of the PMUs discovered on
+// USB are read, then adds the ones that reported one
+void interface::addUSBFixtures(void) {
+  QList<usbDiscovery_t> discoveries = m_usbDiscoveries;
+  m_usbDiscoveries.clear();
+  if (discoveries.isEmpty()) {
+    return;
+  }
+  QEventLoop loop;
+  QFutureWatcher<void> serialNumbersRead;
+  connect(&serialNumbersRead, SIGNAL(finished()), &loop, SLOT(quit()));
+  serialNumbersRead.setFuture(QtConcurrent::run([discoveries]() {
+    foreach (usbDiscovery_t discovery, discoveries) {
+      discovery.serialNumber.waitForFinished();
+    }
+  }));
+  loop.exec();
+  foreach (const usbDiscovery_t &discovery, discoveries) {
+    quint32 serialNumber = discovery.serialNumber.result();
+    bool added = false;
+    if (serialNumber != 0) {
+      QMutexLocker locker(&m_pmuRemotesLock);
+      if (!m_pmuUSBs.contains(serialNumber)) {
+        m_pmuUSBs.insert(serialNumber, discovery.pmuUSB);
+        m_usbPools.insert(serialNumber, discovery.usbPool);
+        if (m_pmuUSB == NULL) {
+          m_pmuUSB = discovery.pmuUSB;
+        }
+        added = true;
+      }
+    }
+    if (!added) {
+      delete discovery.usbPool;
+    }
+    if (serialNumber == 0) {
+      emit connectionStatusChanged("Ignoring a PMU on USB that didn't report its serial number");
+    }
+  }
+}
+
+// starts joining the network and connecting to the fixtures, and returns
+// right away. progress goes to connectionStatusChanged(), the outcome to
+// connectionFinished().
 void interface::connectTelegesis(void) {
+  cancelConnect();
+  if (m_disconnecting) {
+    finishDisconnect();
+  }
+  finishCanceledVerify();
   m_panid = LRNetwork::panidFromNwid(m_networkStr);
   m_chmask = LRNetwork::chmaskFromNwid(m_networkStr);
   joinAndConnectWirelessly();
 }
 
+// stops a connectTelegesis() that is still going. a join or verify that
+// already reached the adapter runs to the end, but its result is dropped.
+void interface::cancelConnect(void) {
+  if (m_connectState == CONNECT_IDLE) {
+    return;
+  }
+  // the fixtures being read can't be removed under the reads, that's left
+  // to on_verifyFinished()
+  m_verifyCanceled = (m_connectState == CONNECT_VERIFYING);
+  m_connectState = CONNECT_IDLE;
+  m_connectTimer.stop();
+  m_connected = false;
+  emit connectionStatusChanged("Connection canceled");
+  emit connectionFinished(false);
+}
+
+// called by the connect functions, in case they come before a canceled
+// verify is done with the fixtures
+void interface::finishCanceledVerify(void) {
+  if (m_verifyCanceled) {
+    m_verifyWatcher.waitForFinished();
+    m_verifyCanceled = false;
+    removeAllFixtures();
+  }
+}
+
+bool interface::isConnecting(void) {
+  return m_connectState != CONNECT_IDLE;
+}
+
+// runs the event loop until connectTelegesis() is done, for callers that
+// have nothing else to do in the meantime
+bool interface::waitForConnection(void) {
+  if (isConnecting()) {
+    QEventLoop loop;
+    connect(this, SIGNAL(connectionFinished(bool)), &loop, SLOT(quit()));
+    loop.exec();
+  }
+  return m_connected;
+}
+
+// stands an in-memory PMU in for every configured serial number, so the
+// helpers can be tried and measured without any hardware
+void interface::connectEmulator(emulatorConfig_t config) {
+  if (m_disconnecting) {
+    finishDisconnect();
+  }
+  finishCanceledVerify();
+  removeAllFixtures();
+  {
+    QMutexLocker locker(&m_pmuRemotesLock);
+    foreach (quint32 serialNumber, m_serialNumbers) {
+      m_emulators.insert(serialNumber, new pmuEmulator(serialNumber, config));
+    }
+  }
+  int numFixtures = fixtures().length();
+  m_connected = (numFixtures > 0);
+  if (numFixtures == 0) {
+    return;
+  } else if (numFixtures == 1) {
+    emit connectionStatusChanged(QString("Emulator connection established"));
+  } else {
+    emit connectionStatusChanged(QString("Emulator connection established to %1 fixtures").arg(numFixtures));
+  }
+  emit connectionEstablished();
+}
+
+// join attempts are spaced 250 ms, 500 ms, 1 s... apart, up to 4 s
+static const int s_maxJoinAttempts = 6;
+// fixtures that don't answer are asked again before they're left out
+static const int s_maxVerifyAttempts = 3;
+
+static int backoffMs(int attempt) {
+  return 250 << qBound(0, attempt - 1, 4);
+}
+
 void interface::joinAndConnectWirelessly(void) {
   GlobalGateway *ggw = GlobalGateway::Instance();
-  Gateway *gw = ggw->getGateway(0);
-  if (!gw) return;
+  Gateway *gw = ggw->getGateway(0, m_interactive);
+  if (!gw) {
+    // in the GUI the user canceled the adapter dialog, nothing to report
+    finishConnect(false, m_interactive ? QString() : "USB Wireless Adapter not found");
+    return;
+  }
   if (m_joined && m_joinedNetworkStr != m_networkStr) {
     emit connectionStatusChanged(QString("Leaving %1 to join %2").arg(m_joinedNetworkStr).arg(m_networkStr));
-    gw->leaveNetwork();
+    ggw->leaveAnyNetwork();
     m_joined = false;
     m_joinedNetworkStr = "";
   }
-  if (m_joined || join()) {
-    connectToFixture();
-    QApplication::processEvents();
+  m_gateways.clear();
+  m_gatewayNetworkStrs.clear();
+  if (m_maxGateways > 1) {
+    int numGateways = ggw->discoverGateways(m_maxGateways);
+    emit connectionStatusChanged(QString("Using %1 of %2 USB Wireless Adapters").arg(numGateways).arg(m_maxGateways));
+  }
+  m_shortPanid = 0;
+  m_hopCount = 0;
+  m_connectAttempt = 1;
+  m_hasNewJoin = false;
+  // start with what worked last time, which skips the bifurcation dialog
+  joinParams_t cached;
+  m_usingCachedJoin = !m_joined && m_joinCache.lookup(m_networkStr, &cached) &&
+                      (cached.panid == m_panid) && (cached.chmask == m_chmask);
+  if (m_usingCachedJoin) {
+    m_shortPanid = cached.shortPanid;
+    m_hopCount = cached.hopCount;
+  }
+  if (m_joined) {
+    startJoinPool();
+  } else if (m_usingCachedJoin && cached.coordinator && m_interactive) {
+    // we coordinated this network last time, with the user's permission
+    emit connectionStatusChanged(QString("Coordinating network %1 as last time").arg(m_networkStr));
+    m_connectState = CONNECT_COORDINATING;
+    startCoordinating();
+  } else {
+    startJoin();
   }
 }
 
-bool interface::join(void) {
+// one attempt to join as a router, on the I/O thread so it queues behind
+// any command still talking to the adapter
+void interface::startJoin(void) {
   GlobalGateway *ggw = GlobalGateway::Instance();
-  DLResult ret = ggw->joinNetwork(m_panid, m_chmask);
-  if (ret == DLLIB_SUCCESS) {
-    // successfully joined network
-    emit connectionStatusChanged(QString("Joined network %1").arg(m_networkStr));
-    m_joined = true;
-    m_joinedNetworkStr = m_networkStr;
-    return true;
+  unsigned long long panid = m_panid;
+  unsigned long chmask = m_chmask;
+  unsigned short shortPanid = m_shortPanid;
+  unsigned int hopCount = m_hopCount;
+  m_connectState = CONNECT_JOINING;
+  if (m_usingCachedJoin) {
+    emit connectionStatusChanged(QString("Joining network %1 as last time").arg(m_networkStr));
   } else {
-    m_joined = false;
-    if (ret == DLLIB_USB_DISCONNECTED) {
-      emit connectionStatusChanged("USB Wireless Adapter disconnected");
+    emit connectionStatusChanged(QString("Joining network %1, attempt %2").arg(m_networkStr).arg(m_connectAttempt));
+  }
+  m_joinWatcher.setFuture(QtConcurrent::run(&m_ioPool, [ggw, panid, chmask, hopCount, shortPanid]() -> int {
+    return ggw->joinAsRouter(panid, chmask, hopCount, shortPanid);
+  }));
+}
+
+void interface::startCoordinating(void) {
+  GlobalGateway *ggw = GlobalGateway::Instance();
+  unsigned long long panid = m_panid;
+  unsigned long chmask = m_chmask;
+  unsigned int hopCount = m_hopCount;
+  m_joinWatcher.setFuture(QtConcurrent::run(&m_ioPool, [ggw, panid, chmask, hopCount]() -> int {
+    return ggw->joinAsCoordinator(panid, chmask, hopCount);
+  }));
+}
+
+QString interface::networkForGateway(int index) {
+  return m_gatewayNetworks.value(index - 1, m_networkStr);
+}
+
+// one adapter of the pool to join
+struct poolJoin_t {
+  int index;
+  unsigned long long panid;
+  unsigned long chmask;
+  unsigned short shortPanid;
+};
+
+// joins the adapters beyond the first, one attempt each, on the I/O thread
+// like the first one. they're not asked to coordinate, an adapter that
+// can't join is left out.
+void interface::startJoinPool(void) {
+  GlobalGateway *ggw = GlobalGateway::Instance();
+  QList<poolJoin_t> joins;
+  if (m_gateways.isEmpty()) {
+    m_gateways << ggw->gatewayAt(0);
+    m_gatewayNetworkStrs << m_networkStr;
+  }
+  for (int index = 1; index < ggw->gatewayCount(); index++) {
+    QString network = networkForGateway(index);
+    poolJoin_t join;
+    if (m_gateways.contains(ggw->gatewayAt(index))) {
+      continue;
+    }
+    join.index = index;
+    join.panid = LRNetwork::panidFromNwid(network);
+    join.chmask = LRNetwork::chmaskFromNwid(network);
+    // the same half of a bifurcated network as the first adapter
+    join.shortPanid = (network == m_networkStr) ? m_shortPanid : 0;
+    joins << join;
+  }
+  if (joins.isEmpty()) {
+    startFixtures();
+    return;
+  }
+  m_connectState = CONNECT_JOINING_POOL;
+  m_poolWatcher.setFuture(QtConcurrent::run(&m_ioPool, [ggw, joins]() -> QMap<int, int> {
+    QMap<int, int> results;
+    foreach (const poolJoin_t &join, joins) {
+      results.insert(join.index, ggw->joinAsRouter(join.panid, join.chmask, 0, join.shortPanid, join.index));
+    }
+    return results;
+  }));
+}
+
+void interface::on_poolJoinFinished(void) {
+  GlobalGateway *ggw = GlobalGateway::Instance();
+  QMap<int, int> results = m_poolWatcher.result();
+  if (m_connectState != CONNECT_JOINING_POOL) {
+    return;
+  }
+  foreach (int index, results.keys()) {
+    EmberGateway *gw = ggw->gatewayAt(index);
+    QString network = networkForGateway(index);
+    if ((results.value(index) == DLLIB_SUCCESS) && (gw != NULL)) {
+      emit connectionStatusChanged(QString("USB Wireless Adapter %1 joined network %2").arg(index + 1).arg(network));
+      m_gateways << gw;
+      m_gatewayNetworkStrs << network;
     } else {
-      emit connectionStatusChanged(QString("Failed to join network %1").arg(m_networkStr));
+      emit connectionStatusChanged(QString("USB Wireless Adapter %1 failed to join network %2, leaving it out").arg(index + 1).arg(network));
     }
   }
-  return false;
+  startFixtures();
 }
 
-void interface::connectToFixture(void) {
-  DLResult ret;
-  unsigned short shortAddr = 0xBAAD;
+void interface::startFixtures(void) {
+  removeAllFixtures();
+  foreach (quint32 serialNumber, m_serialNumbers) {
+    addFixture(serialNumber);
+  }
+  m_connectAttempt = 1;
+  startVerify(m_serialNumbers);
+}
+
+// tries the adapters in order until one gets an answer from the fixture,
+// and leaves the fixture bound to it. each read holds the adapter's lock,
+// like any other command, so it never overlaps with another fixture's.
+static verifyResult_t verifyFixture(PMU_Remote *pmuRemote, QList<EmberGateway *> gateways, QList<int> order) {
+  verifyResult_t verify;
+  verify.result = DLLIB_FAILURE;
+  foreach (int index, order) {
+    QString ignoreStr;
+    GatewayLocker locker(gateways.at(index));
+    verify.gatewayIndex = index;
+    if (!locker.isLocked()) {
+      // pulled out while connecting
+      verify.result = DLLIB_USB_DISCONNECTED;
+      continue;
+    }
+    pmuRemote->setGateway(gateways.at(index));
+    verify.result = pmuRemote->getRegister(PMU_FIRMWARE_VERSION, ignoreStr);
+    if ((verify.result == DLLIB_SUCCESS) || (verify.result == DLLIB_USB_DISCONNECTED)) {
+      break;
+    }
+  }
+  return verify;
+}
+
+// reads the firmware version of all of them at once, a few at a time. the
+// reads are started from the I/O thread, behind anything still queued there.
+// fixtures are spread round robin over the adapters, so commands to
+// different fixtures go out through different adapters. a fixture that
+// doesn't answer is tried once on each of the other networks.
+void interface::startVerify(QList<quint32> serialNumbers) {
+  QMap<quint32, PMU_Remote *> remotes;
+  QMap<quint32, QList<int> > orders;
+  QList<EmberGateway *> gateways = m_gateways;
+  foreach (quint32 serialNumber, serialNumbers) {
+    QList<int> order;
+    QStringList networks;
+    order << (qMax(0, m_serialNumbers.indexOf(serialNumber)) % gateways.length());
+    networks << m_gatewayNetworkStrs.at(order.first());
+    for (int index = 0; index < gateways.length(); index++) {
+      if (!networks.contains(m_gatewayNetworkStrs.at(index))) {
+        order << index;
+        networks << m_gatewayNetworkStrs.at(index);
+      }
+    }
+    remotes.insert(serialNumber, remoteFor(serialNumber));
+    orders.insert(serialNumber, order);
+  }
+  QThreadPool *pool = &m_fixturePool;
+  m_connectState = CONNECT_VERIFYING;
+  m_verifyWatcher.setFuture(QtConcurrent::run(&m_ioPool, [remotes, orders, gateways, pool]() -> QMap<quint32, verifyResult_t> {
+    QMap<quint32, QFuture<verifyResult_t> > pending;
+    QMap<quint32, verifyResult_t> results;
+    foreach (quint32 serialNumber, remotes.keys()) {
+      pending.insert(serialNumber, QtConcurrent::run(pool, verifyFixture, remotes.value(serialNumber), gateways, orders.value(serialNumber)));
+    }
+    foreach (quint32 serialNumber, pending.keys()) {
+      results.insert(serialNumber, pending[serialNumber].result());
+    }
+    return results;
+  }));
+}
+
+void interface::on_joinFinished(void) {
   GlobalGateway *ggw = GlobalGateway::Instance();
-  Gateway *gw = ggw->getGateway(0);
-  if (!m_joined)
+  DLResult ret = (DLResult) m_joinWatcher.result();
+  if ((m_connectState != CONNECT_JOINING) && (m_connectState != CONNECT_COORDINATING)) {
+    // canceled while the adapter was busy
     return;
-  // create a fake PMU bound to m_gateway
-  if (m_pmuRemote != NULL) {
-    delete m_pmuRemote;
   }
-  m_pmuRemote = new PMU_Remote(m_serialNumber, shortAddr);
-  m_pmuRemote->setGateway(gw);
-  // attempt to connect to it
-  QString ignoreStr;
-  m_connected = false;
-  ret = m_pmuRemote->getRegister(PMU_FIRMWARE_VERSION, ignoreStr);
   if (ret == DLLIB_USB_DISCONNECTED) {
-    emit connectionStatusChanged("USB Wireless Adapter disconnected");
     ggw->deleteGateway();
     m_joined = false;
-  } else if (ret != DLLIB_SUCCESS) {
-    emit connectionStatusChanged(QString("Failed to connect to Fixture %1").arg(m_serialNumber));
+    m_gateways.clear();
+    m_gatewayNetworkStrs.clear();
+    finishConnect(false, "USB Wireless Adapter disconnected");
+    return;
+  }
+  if (ret == DLLIB_SUCCESS) {
+    // the wrong half of a bifurcated network joins just as well, so this
+    // is only worth remembering once a fixture answers
+    m_newJoin.panid = m_panid;
+    m_newJoin.chmask = m_chmask;
+    m_newJoin.shortPanid = m_shortPanid;
+    m_newJoin.hopCount = m_hopCount;
+    m_newJoin.coordinator = (m_connectState == CONNECT_COORDINATING);
+    m_hasNewJoin = true;
+    m_usingCachedJoin = false;
+    m_joined = true;
+    m_joinedNetworkStr = m_networkStr;
+    if (m_connectState == CONNECT_COORDINATING) {
+      // give the fixtures a few seconds to join the new network
+      emit connectionStatusChanged(QString("Coordinating network %1, waiting for fixtures to join").arg(m_networkStr));
+      m_connectState = CONNECT_SETTLING;
+      m_connectTimer.start(3000);
+    } else {
+      emit connectionStatusChanged(QString("Joined network %1").arg(m_networkStr));
+      startJoinPool();
+    }
+    return;
+  }
+  m_joined = false;
+  if (m_usingCachedJoin) {
+    // go through the whole sequence, as if nothing was cached
+    m_usingCachedJoin = false;
+    emit connectionStatusChanged(QString("Joining network %1 as last time failed, starting over").arg(m_networkStr));
+    m_joinCache.forget(m_networkStr);
+    m_shortPanid = 0;
+    m_hopCount = 0;
+    m_connectAttempt = 1;
+    startJoin();
+    return;
+  }
+  if (m_connectState == CONNECT_COORDINATING) {
+    finishConnect(false, QString("Failed to join network %1").arg(m_networkStr));
+    return;
+  }
+  // only pick a bifurcated network or coordinate when the user can be asked
+  if ((ret == DLLIB_BIFURCATED_NETWORK) && (m_shortPanid == 0)) {
+    QString selectedNetworkStr;
+    bool ok = false;
+    if (m_interactive && GlobalGateway::askForBifurcatedJoin(ggw->getGateway(0, false), NULL, selectedNetworkStr)) {
+      m_shortPanid = selectedNetworkStr.section(',', 1, 1).toUShort(&ok, 16);
+    }
+    if (m_connectState != CONNECT_JOINING) {
+      return;
+    }
+    if (!ok || (m_shortPanid == 0)) {
+      finishConnect(false, QString("Failed to join network %1").arg(m_networkStr));
+      return;
+    }
+    m_connectAttempt = 1;
+    startJoin();
+    return;
+  }
+  if (m_connectAttempt < s_maxJoinAttempts) {
+    int delayMs = backoffMs(m_connectAttempt);
+    emit connectionStatusChanged(QString("Failed to join network %1, retrying in %2 s").arg(m_networkStr).arg(delayMs / 1000.0));
+    m_connectAttempt++;
+    m_connectTimer.start(delayMs);
+    return;
+  }
+  if (!m_interactive || (m_shortPanid != 0) ||
+      (ggw->allowWirelessCoordinationDialog(m_networkStr) == QMessageBox::No)) {
+    finishConnect(false, QString("Failed to join network %1").arg(m_networkStr));
+    return;
+  }
+  // the dialog ran the event loop, the user may have canceled meanwhile
+  if (m_connectState != CONNECT_JOINING) {
+    return;
+  }
+  emit connectionStatusChanged(QString("Coordinating network %1").arg(m_networkStr));
+  m_connectState = CONNECT_COORDINATING;
+  // let the adapter settle after the last router attempt
+  m_connectTimer.start(250);
+}
+
+void interface::on_verifyFinished(void) {
+  QMap<quint32, verifyResult_t> results = m_verifyWatcher.result();
+  QList<quint32> failed;
+  bool usbDisconnected = false;
+  if (m_verifyCanceled) {
+    m_verifyCanceled = false;
+    removeAllFixtures();
+    return;
+  }
+  if (m_connectState != CONNECT_VERIFYING) {
+    return;
+  }
+  foreach (quint32 serialNumber, results.keys()) {
+    verifyResult_t verify = results.value(serialNumber);
+    if ((verify.result == DLLIB_USB_DISCONNECTED) && (verify.gatewayIndex == 0)) {
+      usbDisconnected = true;
+    } else if (verify.result != DLLIB_SUCCESS) {
+      // includes fixtures behind an extra adapter that was pulled out
+      failed << serialNumber;
+    } else {
+      QMutexLocker locker(&m_pmuRemotesLock);
+      m_fixtureGateways.insert(serialNumber, m_gateways.value(verify.gatewayIndex));
+    }
+  }
+  if (usbDisconnected) {
+    removeAllFixtures();
+    GlobalGateway::Instance()->deleteGateway();
+    m_joined = false;
+    m_gateways.clear();
+    m_gatewayNetworkStrs.clear();
+    finishConnect(false, "USB Wireless Adapter disconnected");
+    return;
+  }
+  if (!failed.isEmpty() && (m_connectAttempt < s_maxVerifyAttempts)) {
+    int delayMs = backoffMs(m_connectAttempt);
+    QString who = (failed.length() == 1) ? QString("Fixture %1").arg(fixtureName(failed.first())) : QString("%1 fixtures").arg(failed.length());
+    emit connectionStatusChanged(QString("%1 not responding, retrying in %2 s").arg(who).arg(delayMs / 1000.0));
+    m_unverifiedFixtures = failed;
+    m_connectAttempt++;
+    m_connectTimer.start(delayMs);
+    return;
+  }
+  // leave unresponsive fixtures out of the session
+  foreach (quint32 serialNumber, failed) {
+    emit connectionStatusChanged(QString("Failed to connect to Fixture %1").arg(fixtureName(serialNumber)));
+    removeFixture(serialNumber);
+  }
+  int numFixtures = fixtures().length();
+  if (numFixtures == 0) {
+    // don't try the same join first next time, and join again instead of
+    // staying on what may be the wrong half of a bifurcated network
+    m_joinCache.forget(m_networkStr);
+    m_joined = false;
+  } else if (m_hasNewJoin) {
+    m_joinCache.store(m_networkStr, m_newJoin);
+  }
+  m_hasNewJoin = false;
+  if (numFixtures == 0) {
+    finishConnect(false, QString());
+  } else if (numFixtures == 1) {
+    finishConnect(true, QString("Telegesis connection established"));
+  } else if (m_gateways.length() == 1) {
+    finishConnect(true, QString("Telegesis connection established to %1 fixtures").arg(numFixtures));
   } else {
-    emit connectionStatusChanged(QString("Telegesis connection established").arg(m_serialNumber));
-    m_connected = true;
+    finishConnect(true, QString("Telegesis connection established to %1 fixtures through %2 adapters").arg(numFixtures).arg(m_gateways.length()));
+  }
+}
+
+// moves the fixtures of an adapter that was pulled out to the first one, or
+// drops them if the first one is gone too. the adapter was closed before
+// this is called, so no command is still out through it and nothing can
+// use the fixtures' remotes until they're moved.
+void interface::on_gatewayRemoved(Gateway *gw) {
+  EmberGateway *firstGw = GlobalGateway::Instance()->gatewayAt(0);
+  QList<PMU_Remote *> dropped;
+  int numMoved = 0;
+  for (int index = 1; index < m_gateways.length(); index++) {
+    if (static_cast<Gateway *>(m_gateways.at(index)) == gw) {
+      m_gateways.removeAt(index);
+      m_gatewayNetworkStrs.removeAt(index);
+      break;
+    }
+  }
+  {
+    // commands look the remote up under this lock, see lockGatewayFor()
+    QMutexLocker locker(&m_pmuRemotesLock);
+    QHash<quint32, EmberGateway *>::iterator i = m_fixtureGateways.begin();
+    while (i != m_fixtureGateways.end()) {
+      if (static_cast<Gateway *>(i.value()) != gw) {
+        ++i;
+      } else if (firstGw == NULL) {
+        dropped << m_pmuRemotes.take(i.key());
+        i = m_fixtureGateways.erase(i);
+      } else {
+        i.value() = firstGw;
+        if (m_pmuRemotes.contains(i.key())) {
+          m_pmuRemotes.value(i.key())->setGateway(firstGw);
+        }
+        numMoved++;
+        ++i;
+      }
+    }
+  }
+  qDeleteAll(dropped);
+  if (numMoved > 0) {
+    emit connectionStatusChanged(QString("A USB Wireless Adapter was pulled out, moved its %1 fixtures to the first one").arg(numMoved));
+  } else if (!dropped.isEmpty()) {
+    emit connectionStatusChanged(QString("A USB Wireless Adapter was pulled out with the first one gone too, dropped its %1 fixtures").arg(dropped.length()));
+  }
+}
+
+void interface::on_connectTimeout(void) {
+  switch (m_connectState) {
+  case CONNECT_JOINING:
+    startJoin();
+    break;
+  case CONNECT_COORDINATING:
+    startCoordinating();
+    break;
+  case CONNECT_SETTLING:
+    startJoinPool();
+    break;
+  case CONNECT_VERIFYING:
+    startVerify(m_unverifiedFixtures);
+    break;
+  default:
+    break;
+  }
+}
+
+void interface::finishConnect(bool connected, QString status) {
+  m_connectState = CONNECT_IDLE;
+  m_connected = connected;
+  if (!status.isEmpty()) {
+    emit connectionStatusChanged(status);
+  }
+  if (connected) {
     emit connectionEstablished();
   }
+  emit connectionFinished(connected);
 }
 
-QStringList interface::queryPmu(QStringList cmdList) {
-  DLResult ret;
-  QString response;
-  QStringList responseList;
-  QMap <QString, QString> errorResponses;
+static QHash <QString, QString> buildErrorResponses(void) {
+  QHash <QString, QString> errorResponses;
   errorResponses.insert("ERROR: FFFF", "ERROR: Invalid opcode");
   errorResponses.insert("ERROR: FFFE", "ERROR: Syntax error");
   errorResponses.insert("ERROR: FFFD", "ERROR: Invalid register");
@@ -148,29 +1059,275 @@ QStringList interface::queryPmu(QStringList cmdList) {
   errorResponses.insert("ERROR: FFF0", "ERROR: Bus error");
   errorResponses.insert("ERROR: FFEF", "ERROR: Bus busy");
   errorResponses.insert("ERROR: FFEE", "ERROR: Resource busy");
-  foreach (const QString &cmd, cmdList) {
-    // figure out the length NOT including the space
-    int len = cmd.length();
-    int i = cmd.indexOf(' ');
-    if (i != -1) {
-      len = cmd.left(i).length();
-    }
-    if (m_pmuUSB == NULL) {
-      GlobalGateway *ggw = GlobalGateway::Instance();
-      Gateway *gw = ggw->getGateway(0);
-      ret = gw->issuePMUCommand(m_pmuRemote, cmd, response, len);
+  return errorResponses;
+}
+
+QString interface::translateError(QString response) {
+  // built once; safe to share between pipelined worker threads
+  static const QHash <QString, QString> errorResponses = buildErrorResponses();
+  return errorResponses.value(response, response);
+}
+
+QString interface::issueCommand(quint32 serialNumber, pmuEmulator *emulator, PMU_USB *pmuUSB, QString cmd) {
+  DLResult ret;
+  QString response;
+  if (m_canceling.load()) {
+    return QString("ERROR: Request canceled");
+  }
+  // figure out the length NOT including the space
+  int len = cmd.length();
+  int i = cmd.indexOf(' ');
+  if (i != -1) {
+    len = cmd.left(i).length();
+  }
+  if (emulator != NULL) {
+    response = emulator->issueCommand(cmd);
+  } else if (pmuUSB == NULL) {
+    // one command at a time is out on an adapter, see GlobalGateway::lockGateway()
+    PMU_Remote *pmuRemote = NULL;
+    Gateway *gw = lockGatewayFor(serialNumber, &pmuRemote);
+    if (gw == NULL) {
+      return QString("ERROR: Fixture not connected");
+    }
+    ret = gw->issuePMUCommand(pmuRemote, cmd, response, len);
+    GlobalGateway::Instance()->unlockGateway(gw);
+  } else {
+    ret = pmuUSB->issueCommand(cmd, response, len);
+    if (ret != DLLIB_SUCCESS) {
+      return QString("ERROR: %1").arg(ret);
+    }
+  }
+  // parse error
+  if (response.startsWith("ERROR")) {
+    return translateError(response);
+  }
+  return response;
+}
+
+// reads worth sending to the current fixture before waiting for a reply.
+// an adapter or a USB cable carries one command at a time, so only an
+// emulated fixture gets more than one.
+int interface::pipelineDepth(void) {
+  return (emulatorFor(currentFixture()) != NULL) ? s_pipelineDepth : 1;
+}
+
+// register, RAM and log reads, which change nothing on the fixture
+static bool isReadCommand(const QString &cmd) {
+  QChar opcode = cmd.isEmpty() ? QChar() : cmd.at(0).toUpper();
+  return (opcode == 'G') || (opcode == 'R') || (opcode == 'K');
+}
+
+QStringList interface::queryPmu(QStringList cmdList) {
+  QStringList responseList;
+  QList<int> pending;
+  pmuEmulator *emulator = NULL;
+  PMU_USB *pmuUSB = NULL;
+  QThreadPool *usbPool = NULL;
+  quint32 serialNumber = currentFixture();
+  {
+    // written by the connect functions on another thread
+    QMutexLocker locker(&m_pmuRemotesLock);
+    pmuUSB = m_pmuUSBs.value(serialNumber, NULL);
+    usbPool = m_usbPools.value(serialNumber, NULL);
+    emulator = m_emulators.value(serialNumber, NULL);
+  }
+  // serve what we can from the register cache
+  for (int i = 0; i < cmdList.length(); i++) {
+    QString response;
+    if (cacheLookup(serialNumber, cmdList.at(i), &response)) {
+      responseList << response;
     } else {
-      ret = m_pmuUSB->issueCommand(cmd, response, len);
-      if (ret != DLLIB_SUCCESS ) {
-        responseList << QString("ERROR: %1").arg(ret);
+      responseList << QString();
+      pending << i;
+    }
+  }
+  if (usbPool != NULL) {
+    // a PMU on USB is only ever talked to from its own thread, so commands
+    // to different PMUs run side by side and never interleave on one cable
+    QtConcurrent::run(usbPool, [&]() {
+      foreach (int i, pending) {
+        responseList[i] = issueCommand(serialNumber, emulator, pmuUSB, cmdList.at(i));
       }
+    }).waitForFinished();
+  } else if ((emulator == NULL) || (pending.length() < 2)) {
+    // one command at a time, waiting for each reply before sending the next
+    foreach (int i, pending) {
+      responseList[i] = issueCommand(serialNumber, emulator, pmuUSB, cmdList.at(i));
     }
-    // parse error
-    if (response.startsWith("ERROR")) {
-      responseList << errorResponses[response];
-    } else {
-      responseList << response;
+  } else {
+    // an emulated fixture answers up to s_pipelineDepth reads side by side.
+    // writes, resets, reloads and anything else go out alone, in order, once
+    // every command before them was answered.
+    QList<QFuture<QString> > inFlight;
+    QList<int> inFlightIndexes;
+    auto collect = [&]() {
+      for (int j = 0; j < inFlight.length(); j++) {
+        responseList[inFlightIndexes.at(j)] = inFlight[j].result();
+      }
+      inFlight.clear();
+      inFlightIndexes.clear();
+    };
+    foreach (int i, pending) {
+      if (isReadCommand(cmdList.at(i))) {
+        inFlight << QtConcurrent::run(&m_pipelinePool, this, &interface::issueCommand, serialNumber, emulator, pmuUSB, cmdList.at(i));
+        inFlightIndexes << i;
+      } else {
+        collect();
+        responseList[i] = issueCommand(serialNumber, emulator, pmuUSB, cmdList.at(i));
+      }
     }
+    collect();
+  }
+  foreach (int i, pending) {
+    cacheUpdate(serialNumber, cmdList.at(i), responseList.at(i));
+    recordSample(serialNumber, cmdList.at(i), responseList.at(i));
   }
   return responseList;
 }
+
+// returns the register a plain "Gnnnn" read or "Snnnn value" write addresses,
+// always in its "Gnnnn" form, or an empty string for any other command
+static QString registerFromCommand(const QString &cmd, QChar opcode) {
+  if ((cmd.length() < 5) || (cmd.at(0).toUpper() != opcode)) {
+    return QString();
+  }
+  if ((opcode == 'G') && (cmd.length() != 5)) {
+    return QString();
+  }
+  if ((opcode == 'S') && (cmd.length() > 5) && (cmd.at(5) != ' ')) {
+    return QString();
+  }
+  bool ok;
+  cmd.mid(1, 4).toUShort(&ok, 16);
+  return ok ? ("G" + cmd.mid(1, 4).toUpper()) : QString();
+}
+
+void interface::setCachePolicy(QString reg, cachePolicy policy, int ttlMs) {
+  QMutexLocker locker(&m_cacheLock);
+  cachePolicy_t entry;
+  entry.policy = policy;
+  entry.ttlMs = ttlMs;
+  m_cachePolicies.insert(reg.toUpper(), entry);
+}
+
+void interface::clearCache(void) {
+  QMutexLocker locker(&m_cacheLock);
+  m_registerCache.clear();
+}
+
+quint64 interface::cacheHits(void) {
+  QMutexLocker locker(&m_cacheLock);
+  return m_cacheHits;
+}
+
+quint64 interface::cacheMisses(void) {
+  QMutexLocker locker(&m_cacheLock);
+  return m_cacheMisses;
+}
+
+bool interface::cacheLookup(quint32 serialNumber, const QString &cmd, QString *response) {
+  QString reg = registerFromCommand(cmd, 'G');
+  if (reg.isEmpty()) {
+    return false;
+  }
+  QMutexLocker locker(&m_cacheLock);
+  cachePolicy_t policy = m_cachePolicies.value(reg);
+  if (policy.policy == CACHE_NEVER) {
+    return false;
+  }
+  if (!s_requestContext.localData().bypassCache && m_registerCache[serialNumber].contains(reg)) {
+    const cacheEntry_t &entry = m_registerCache[serialNumber][reg];
+    if ((policy.policy == CACHE_IMMUTABLE) ||
+        ((QDateTime::currentMSecsSinceEpoch() - entry.timestamp) < policy.ttlMs)) {
+      m_cacheHits++;
+      *response = entry.value;
+      return true;
+    }
+  }
+  m_cacheMisses++;
+  return false;
+}
+
+void interface::cacheUpdate(quint32 serialNumber, const QString &cmd, const QString &response) {
+  QMutexLocker locker(&m_cacheLock);
+  QString reg = registerFromCommand(cmd, 'G');
+  if (!reg.isEmpty()) {
+    // remember successful reads of cacheable registers
+    if ((m_cachePolicies.value(reg).policy != CACHE_NEVER) && !response.startsWith("ERROR")) {
+      cacheEntry_t entry;
+      entry.value = response;
+      entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+      m_registerCache[serialNumber].insert(reg, entry);
+    }
+    return;
+  }
+  reg = registerFromCommand(cmd, 'S');
+  if (!reg.isEmpty()) {
+    // a write makes the cached value stale
+    m_registerCache[serialNumber].remove(reg);
+  } else if (cmd.startsWith("!")) {
+    // resets, reboots and reloads may change anything
+    m_registerCache.remove(serialNumber);
+  }
+}
+
+// reads of the recorded registers go to recorder until it's set to NULL.
+// the interface doesn't take ownership.
+void interface::setRecorder(sampleRecorder *recorder) {
+  QMutexLocker locker(&m_recorderLock);
+  m_recorder = recorder;
+}
+
+// only reads that actually went to the fixture are recorded, never cache
+// hits. samples go under the fixture's serial number, for PMUs on USB too.
+void interface::recordSample(quint32 serialNumber, const QString &cmd, const QString &response) {
+  QMutexLocker locker(&m_recorderLock);
+  if (m_recorder == NULL) {
+    return;
+  }
+  QString reg = registerFromCommand(cmd, 'G');
+  if (reg.isEmpty() || response.startsWith("ERROR")) {
+    return;
+  }
+  m_recorder->record(serialNumber, reg.mid(1).toUShort(0, 16), QDateTime::currentMSecsSinceEpoch(), response);
+}
+
+int interface::queryPmuAsync(QStringList cmdList) {
+  return runAsync(cmdHandler_t(), cmdList);
+}
+
+int interface::runAsync(cmdHandler_t handler, QStringList argList, bool useCache) {
+  // the result is delivered through requestFinished(requestId, ...)
+  int requestId = m_nextRequestId++;
+  QtConcurrent::run(&m_ioPool, this, &interface::runRequest, requestId, handler, argList, useCache);
+  return requestId;
+}
+
+// runs a request on the calling thread, on every fixture of the session
+QStringList interface::run(cmdHandler_t handler, QStringList argList, bool useCache) {
+  QStringList responseList;
+  QList<quint32> serialNumbers = fixtures();
+  s_requestContext.localData().bypassCache = !useCache;
+  if (serialNumbers.length() > 1) {
+    // fan the request out to every fixture of the session
+    QMap<quint32, QStringList> results = queryFixtures(serialNumbers, handler, argList, useCache);
+    foreach (quint32 serialNumber, results.keys()) {
+      responseList << QString("+[Fixture %1]").arg(fixtureName(serialNumber));
+      responseList << results[serialNumber];
+    }
+  } else if (!handler) {
+    // raw commands
+    responseList = queryPmu(argList);
+  } else {
+    // pass control to the helper
+    responseList = handler(argList, this);
+  }
+  s_requestContext.localData().bypassCache = false;
+  return responseList;
+}
+
+void interface::runRequest(int requestId, cmdHandler_t handler, QStringList argList, bool useCache) {
+  QStringList responseList = run(handler, argList, useCache);
+  // emitted from the I/O thread, so receivers in the GUI thread get it queued
+  emit requestFinished(requestId, responseList);
+}
@@ -2,8 +2,39 @@
 #define INTERFACE_H
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include "cmdhelper.h"
+#include "pmuemulator.h"
+#include "joincache.h"
+
+// one helper or raw command of a sweep
+struct sweepRequest_t {
+  cmdHandler_t handler;
+  QStringList argList;
+  bool useCache;
+};
+
+// gets the results of every request of a sweep for one fixture, in request order
+typedef std::function<void(quint32 serialNumber, QList<QStringList> results)> sweepCallback_t;
+
+// outcome of reading a fixture's firmware version while connecting, and
+// the adapter it answered through
+struct verifyResult_t {
+  verifyResult_t() : result(0), gatewayIndex(0) {}
+  int result;
+  int gatewayIndex;
+};
 
 class DiscoveryAgent;
+class EmberGateway;
+class sampleRecorder;
 class Gateway;
 class PMU;
 class PMU_Remote;
@@ -13,38 +44,177 @@ class interface : public QObject
 {
   Q_OBJECT
 public:
+  enum cachePolicy {
+    // always read from the fixture
+    CACHE_NEVER,
+    // read once per session, until written or the fixture is reset
+    CACHE_IMMUTABLE,
+    // reuse a read for ttlMs milliseconds
+    CACHE_TTL
+  };
   explicit interface(QObject *parent = 0);
   void configure(QString network, quint32 serialNumber);
-  void connectFTDI(void);
+  void configure(QString network, QList<quint32> serialNumbers);
+  void setInteractive(bool interactive);
+  void setGateways(int maxGateways, QStringList networks = QStringList());
+  void connectFTDI(int timeoutMs = -1);
+  void setDeviceDirectory(QString directory);
   void connectTelegesis(void);
+  void cancelConnect(void);
+  bool isConnecting(void);
+  bool waitForConnection(void);
+  void connectEmulator(emulatorConfig_t config = emulatorConfig_t());
   void disconnect(void);
   bool isConnected(void);
   QStringList queryPmu(QStringList cmdList);
+  int pipelineDepth(void);
+  int queryPmuAsync(QStringList cmdList);
+  int runAsync(cmdHandler_t handler, QStringList argList, bool useCache = true);
+  QStringList run(cmdHandler_t handler, QStringList argList, bool useCache = true);
+  void addFixture(quint32 serialNumber);
+  void removeFixture(quint32 serialNumber);
+  QList<quint32> fixtures(void);
+  quint32 currentFixture(void);
+  void setMaxConcurrentFixtures(int maxFixtures);
+  QMap<quint32, QStringList> queryFixtures(QList<quint32> serialNumbers, cmdHandler_t handler, QStringList argList, bool useCache = true);
+  void sweep(QList<quint32> serialNumbers, QList<sweepRequest_t> requests, sweepCallback_t onFixtureDone);
+  static QList<quint32> parseSerialNumbers(QString text, bool *ok = 0);
+  static QString fixtureName(quint32 serialNumber);
+  void setCachePolicy(QString reg, cachePolicy policy, int ttlMs = 0);
+  void clearCache(void);
+  quint64 cacheHits(void);
+  quint64 cacheMisses(void);
+  void setRecorder(sampleRecorder *recorder);
 
 signals:
   void connectionEstablished(void);
   void connectionStatusChanged(QString status);
+  void connectionFinished(bool connected);
+  void requestFinished(int requestId, QStringList responseList);
 
 public slots:
 
 private:
-  PMU_Remote *m_pmuRemote;
+  struct cachePolicy_t {
+    cachePolicy_t() : policy(CACHE_NEVER), ttlMs(0) {}
+    cachePolicy policy;
+    int ttlMs;
+  };
+  // steps of connectTelegesis(), each waits on a worker thread or a timer
+  enum connectState {
+    CONNECT_IDLE,
+    CONNECT_JOINING,
+    CONNECT_COORDINATING,
+    CONNECT_SETTLING,
+    CONNECT_JOINING_POOL,
+    CONNECT_VERIFYING
+  };
+  struct cacheEntry_t {
+    QString value;
+    qint64 timestamp;
+  };
+  // a PMU on USB whose serial number is read on its own thread
+  struct usbDiscovery_t {
+    PMU_USB *pmuUSB;
+    QThreadPool *usbPool;
+    QFuture<quint32> serialNumber;
+  };
+  QMap<quint32, PMU_Remote*> m_pmuRemotes;
+  QMap<quint32, pmuEmulator*> m_emulators;
+  QMutex m_pmuRemotesLock;
+  // the first PMU on USB, set while the session is wired
   PMU_USB *m_pmuUSB;
+  // every PMU on USB by serial number, each with a single thread pool,
+  // guarded by m_pmuRemotesLock
+  QMap<quint32, PMU_USB*> m_pmuUSBs;
+  QMap<quint32, QThreadPool*> m_usbPools;
+  QList<usbDiscovery_t> m_usbDiscoveries;
   DiscoveryAgent *m_discoveryAgent;
-  quint32 m_serialNumber;
+  QString m_deviceDirectory;
+  QList<quint32> m_serialNumbers;
   unsigned long long m_panid;
   unsigned long m_chmask;
   QString m_networkStr;
   QString m_joinedNetworkStr;
+  connectState m_connectState;
+  int m_connectAttempt;
+  // picks one half of a bifurcated network, 0 for none
+  unsigned short m_shortPanid;
+  unsigned int m_hopCount;
+  joinCache m_joinCache;
+  // the current attempt uses the last successful join of the network
+  bool m_usingCachedJoin;
+  // the join of this connect, cached once a fixture answers through it
+  joinParams_t m_newJoin;
+  bool m_hasNewJoin;
+  QTimer m_connectTimer;
+  QFutureWatcher<int> m_joinWatcher;
+  QFutureWatcher<QMap<int, int> > m_poolWatcher;
+  QFutureWatcher<QMap<quint32, verifyResult_t> > m_verifyWatcher;
+  int m_maxGateways;
+  // networks of the extra adapters, the session's network where missing
+  QStringList m_gatewayNetworks;
+  // joined adapters, the first one first, and the network of each
+  QList<EmberGateway *> m_gateways;
+  QStringList m_gatewayNetworkStrs;
+  // adapter each fixture answered through, guarded by m_pmuRemotesLock
+  QHash<quint32, EmberGateway *> m_fixtureGateways;
+  QList<quint32> m_unverifiedFixtures;
   bool m_joined;
   bool m_connected;
+  // requests fail at their next command while set, see disconnect()
+  QAtomicInt m_canceling;
+  bool m_disconnecting;
+  // cancelConnect() came while verifying, see on_verifyFinished()
+  bool m_verifyCanceled;
+  QFutureWatcher<void> m_drainWatcher;
   bool m_closed;
+  bool m_interactive;
+  QThreadPool m_pipelinePool;
+  QThreadPool m_ioPool;
+  QThreadPool m_fixturePool;
+  int m_nextRequestId;
+  QHash<QString, cachePolicy_t> m_cachePolicies;
+  QHash<quint32, QHash<QString, cacheEntry_t> > m_registerCache;
+  QMutex m_cacheLock;
+  quint64 m_cacheHits;
+  quint64 m_cacheMisses;
+  sampleRecorder *m_recorder;
+  QMutex m_recorderLock;
   void joinAndConnectWirelessly(void);
-  bool join(void);
-  void connectToFixture(void);
+  void startJoin(void);
+  void startCoordinating(void);
+  void startJoinPool(void);
+  void startFixtures(void);
+  QString networkForGateway(int index);
+  Gateway *gatewayFor(quint32 serialNumber);
+  void startVerify(QList<quint32> serialNumbers);
+  void finishConnect(bool connected, QString status);
+  void finishDisconnect(void);
+  void finishCanceledVerify(void);
+  void addUSBFixtures(void);
+  void removeAllFixtures(void);
+  void deleteRemote(PMU_Remote *pmuRemote, Gateway *gw);
+  PMU_Remote *remoteFor(quint32 serialNumber);
+  Gateway *lockGatewayFor(quint32 serialNumber, PMU_Remote **pmuRemote);
+  pmuEmulator *emulatorFor(quint32 serialNumber);
+  QStringList runOnFixture(quint32 serialNumber, cmdHandler_t handler, QStringList argList, bool useCache);
+  QList<QStringList> sweepFixture(quint32 serialNumber, QList<sweepRequest_t> requests);
+  QString issueCommand(quint32 serialNumber, pmuEmulator *emulator, PMU_USB *pmuUSB, QString cmd);
+  static QString translateError(QString response);
+  void runRequest(int requestId, cmdHandler_t handler, QStringList argList, bool useCache);
+  bool cacheLookup(quint32 serialNumber, const QString &cmd, QString *response);
+  void cacheUpdate(quint32 serialNumber, const QString &cmd, const QString &response);
+  void recordSample(quint32 serialNumber, const QString &cmd, const QString &response);
 
 private slots:
   void slotPMUDiscovered(PMU* pmu);
+  void on_joinFinished(void);
+  void on_poolJoinFinished(void);
+  void on_verifyFinished(void);
+  void on_gatewayRemoved(Gateway *gw);
+  void on_connectTimeout(void);
+  void on_ioDrained(void);
 };
 
 #endif // INTERFACE_H
@@ -0,0 +1,51 @@
+#include "joincache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+
+joinCache::joinCache(QString path) :
+  m_path(path.isEmpty() ? defaultPath() : path) {
+}
+
+QString joinCache::defaultPath(void) {
+  return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("joins.ini");
+}
+
+// false if the network was never joined, or the entry is unreadable
+bool joinCache::lookup(QString networkStr, joinParams_t *params) {
+  QSettings cache(m_path, QSettings::IniFormat);
+  bool panidOk;
+  bool chmaskOk;
+  cache.beginGroup(networkStr);
+  if (!cache.contains("panid")) {
+    return false;
+  }
+  params->panid = cache.value("panid").toString().toULongLong(&panidOk, 16);
+  params->chmask = cache.value("chmask").toString().toULong(&chmaskOk, 16);
+  params->shortPanid = cache.value("shortPanid", 0).toString().toUShort(0, 16);
+  params->hopCount = cache.value("hopCount", 0).toUInt();
+  params->coordinator = (cache.value("role").toString() == "coordinator");
+  return panidOk && chmaskOk;
+}
+
+bool joinCache::store(QString networkStr, const joinParams_t &params) {
+  QDir().mkpath(QFileInfo(m_path).absolutePath());
+  QSettings cache(m_path, QSettings::IniFormat);
+  cache.beginGroup(networkStr);
+  cache.setValue("panid", QString::number(params.panid, 16));
+  cache.setValue("chmask", QString::number(params.chmask, 16));
+  cache.setValue("shortPanid", QString::number(params.shortPanid, 16));
+  cache.setValue("hopCount", params.hopCount);
+  cache.setValue("role", params.coordinator ? "coordinator" : "router");
+  cache.setValue("lastJoin", QDateTime::currentDateTime().toString(Qt::ISODate));
+  cache.endGroup();
+  cache.sync();
+  return (cache.status() == QSettings::NoError);
+}
+
+void joinCache::forget(QString networkStr) {
+  QSettings cache(m_path, QSettings::IniFormat);
+  cache.remove(networkStr);
+}
@@ -0,0 +1,32 @@
+#ifndef JOINCACHE_H
+#define JOINCACHE_H
+
+#include <QString>
+
+// how the adapter last joined a network successfully
+struct joinParams_t {
+  joinParams_t() : panid(0), chmask(0), shortPanid(0), hopCount(0), coordinator(false) {}
+  unsigned long long panid;
+  unsigned long chmask;
+  // the half of a bifurcated network that was picked, 0 for none
+  unsigned short shortPanid;
+  unsigned int hopCount;
+  bool coordinator;
+};
+
+// the last successful join of every network, kept on disk so the next
+// session can try it first instead of retrying and asking all over again
+class joinCache
+{
+public:
+  explicit joinCache(QString path = QString());
+  bool lookup(QString networkStr, joinParams_t *params);
+  bool store(QString networkStr, const joinParams_t &params);
+  void forget(QString networkStr);
+  static QString defaultPath(void);
+
+private:
+  QString m_path;
+};
+
+#endif // JOINCACHE_H
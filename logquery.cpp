@@ -0,0 +1,166 @@
+#include "logquery.h"
+#include "interface.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+struct eventTypeName_t {
+  const char *name;
+  quint8 eventType;
+};
+
+// names accepted by "type", see eventLog::describe()
+static const eventTypeName_t s_eventTypeNames[] = {
+  { "power", 0x00 },
+  { "activity", 0x01 },
+  { "sensor", 0x03 },
+  { "serialnet", 0x04 },
+  { "temperature", 0x05 },
+  { "lightbar", 0x06 },
+  { "rtc", 0x07 },
+  { "battery", 0x08 },
+  { "i2c", 0x09 },
+  { "restore", 0x0A },
+  { "ember", 0x0B }
+};
+
+logQuery *logQuery::shared(void) {
+  // filled by get log, read by query log
+  static logQuery query;
+  return &query;
+}
+
+// replaces what is known about a fixture's log and rebuilds its indexes
+void logQuery::setEntries(quint32 serialNumber, const QVector<logEntry_t> &entries) {
+  fixtureLog_t log;
+  log.entries = entries;
+  for (int i = 0; i < entries.size(); i++) {
+    log.byType[entries.at(i).eventType].append(i);
+  }
+  // uptimes only go backwards when a log was reset, keep log order for ties
+  for (QHash<quint8, QVector<int> >::iterator i = log.byType.begin(); i != log.byType.end(); ++i) {
+    std::stable_sort(i.value().begin(), i.value().end(), [&entries](int a, int b) {
+      return entries.at(a).uptime < entries.at(b).uptime;
+    });
+  }
+  QMutexLocker locker(&m_lock);
+  m_logs.insert(serialNumber, log);
+}
+
+bool logQuery::contains(quint32 serialNumber) {
+  QMutexLocker locker(&m_lock);
+  return m_logs.contains(serialNumber);
+}
+
+QList<quint32> logQuery::fixtures(void) {
+  QMutexLocker locker(&m_lock);
+  QList<quint32> serialNumbers = m_logs.keys();
+  std::sort(serialNumbers.begin(), serialNumbers.end());
+  return serialNumbers;
+}
+
+// matches are grouped by fixture, in log order
+QVector<logMatch_t> logQuery::find(const logQueryFilter_t &filter) {
+  QVector<logMatch_t> matches;
+  QList<quint32> serialNumbers = filter.serialNumbers.isEmpty() ? fixtures() : filter.serialNumbers;
+  QMutexLocker locker(&m_lock);
+  foreach (quint32 serialNumber, serialNumbers) {
+    if (!m_logs.contains(serialNumber)) {
+      continue;
+    }
+    const fixtureLog_t &log = m_logs[serialNumber];
+    QList<quint8> eventTypes = filter.eventTypes.isEmpty() ? log.byType.keys() : filter.eventTypes;
+    QVector<int> positions;
+    foreach (quint8 eventType, eventTypes) {
+      if (!log.byType.contains(eventType)) {
+        continue;
+      }
+      // skip straight to the start of the window
+      const QVector<int> &index = log.byType[eventType];
+      QVector<int>::const_iterator i = std::lower_bound(index.constBegin(), index.constEnd(), filter.fromUptime,
+                                                        [&log](int position, quint32 uptime) {
+        return log.entries.at(position).uptime < uptime;
+      });
+      for (; (i != index.constEnd()) && (log.entries.at(*i).uptime <= filter.toUptime); ++i) {
+        positions.append(*i);
+      }
+    }
+    std::sort(positions.begin(), positions.end());
+    if ((filter.limit > 0) && (positions.size() > filter.limit)) {
+      positions = positions.mid(positions.size() - filter.limit);
+    }
+    foreach (int position, positions) {
+      logMatch_t match;
+      match.serialNumber = serialNumber;
+      match.entry = log.entries.at(position);
+      matches.append(match);
+    }
+  }
+  return matches;
+}
+
+// type <name|hex>[,...] from <uptime> to <uptime> fixture <serials> limit <n>,
+// all optional and in any order
+bool logQuery::parseFilter(QStringList argList, logQueryFilter_t *filter, QString *error) {
+  bool ok;
+  *filter = logQueryFilter_t();
+  for (int i = 0; i < argList.length(); i += 2) {
+    QString keyword = argList.at(i).toLower();
+    if (i + 1 >= argList.length()) {
+      *error = QString("ERROR: expected a value after %1").arg(keyword);
+      return false;
+    }
+    QString value = argList.at(i + 1);
+    if (keyword == "type") {
+      foreach (const QString &name, value.toLower().split(',', QString::SkipEmptyParts)) {
+        int eventType = -1;
+        for (size_t j = 0; j < sizeof(s_eventTypeNames) / sizeof(s_eventTypeNames[0]); j++) {
+          if (name == s_eventTypeNames[j].name) {
+            eventType = s_eventTypeNames[j].eventType;
+          }
+        }
+        if (eventType < 0) {
+          eventType = name.toUShort(&ok, 16);
+          if (!ok || (eventType > 0xFF)) {
+            *error = QString("ERROR: unknown event type %1, expected one of %2").arg(name, eventTypeNames().join(", "));
+            return false;
+          }
+        }
+        filter->eventTypes << eventType;
+      }
+    } else if (keyword == "from") {
+      if (!eventLog::parseUptime(value, &filter->fromUptime)) {
+        *error = "ERROR: expected an uptime like 1Y:2D:3H after from";
+        return false;
+      }
+    } else if (keyword == "to") {
+      if (!eventLog::parseUptime(value, &filter->toUptime)) {
+        *error = "ERROR: expected an uptime like 1Y:2D:3H after to";
+        return false;
+      }
+    } else if (keyword == "fixture") {
+      filter->serialNumbers = interface::parseSerialNumbers(value, &ok);
+      if (!ok) {
+        *error = "ERROR: expected serial numbers after fixture";
+        return false;
+      }
+    } else if (keyword == "limit") {
+      filter->limit = value.toInt(&ok);
+      if (!ok || (filter->limit < 0)) {
+        *error = "ERROR: expected a number after limit";
+        return false;
+      }
+    } else {
+      *error = QString("ERROR: unknown query keyword %1").arg(keyword);
+      return false;
+    }
+  }
+  return true;
+}
+
+QStringList logQuery::eventTypeNames(void) {
+  QStringList names;
+  for (size_t i = 0; i < sizeof(s_eventTypeNames) / sizeof(s_eventTypeNames[0]); i++) {
+    names << s_eventTypeNames[i].name;
+  }
+  return names;
+}
@@ -0,0 +1,51 @@
+#ifndef LOGQUERY_H
+#define LOGQUERY_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+#include "eventlog.h"
+
+// what a log query looks for. empty lists match everything.
+struct logQueryFilter_t {
+  logQueryFilter_t() : fromUptime(0), toUptime(0xFFFFFFFF), limit(0) {}
+  QList<quint8> eventTypes;
+  QList<quint32> serialNumbers;
+  // uptime window in seconds, both ends included
+  quint32 fromUptime;
+  quint32 toUptime;
+  // at most this many matches per fixture, the most recent ones, 0 for all
+  int limit;
+};
+
+struct logMatch_t {
+  quint32 serialNumber;
+  logEntry_t entry;
+};
+
+// the downloaded event logs of many fixtures, indexed by event type and
+// uptime so a query only touches the entries it returns
+class logQuery
+{
+public:
+  static logQuery *shared(void);
+  void setEntries(quint32 serialNumber, const QVector<logEntry_t> &entries);
+  bool contains(quint32 serialNumber);
+  QList<quint32> fixtures(void);
+  QVector<logMatch_t> find(const logQueryFilter_t &filter);
+  static bool parseFilter(QStringList argList, logQueryFilter_t *filter, QString *error);
+  static QStringList eventTypeNames(void);
+
+private:
+  struct fixtureLog_t {
+    QVector<logEntry_t> entries;
+    // positions in entries for every event type, ordered by uptime
+    QHash<quint8, QVector<int> > byType;
+  };
+  QMutex m_lock;
+  QHash<quint32, fixtureLog_t> m_logs;
+};
+
+#endif // LOGQUERY_H
@@ -0,0 +1,226 @@
+#include "logstore.h"
+#include "interface.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+
+// true if index lies between the oldest (head) and one past the newest (tail) entry
+static bool isOnFixture(int index, const logIndex_t &logIndex) {
+  return quint16(index - logIndex.head) <= quint16(logIndex.tail - logIndex.head);
+}
+
+static bool isSameEntry(const logEntry_t &a, const logEntry_t &b) {
+  return (a.uptime == b.uptime) && (a.eventType == b.eventType) &&
+         (a.valueSize == b.valueSize) && (a.value == b.value);
+}
+
+logStore::logStore(quint32 serialNumber, QString directory) :
+  m_nextIndex(-1),
+  m_epoch(0) {
+  if (directory.isEmpty()) {
+    directory = defaultDirectory();
+  }
+  QDir().mkpath(directory);
+  m_logPath = QDir(directory).filePath(interface::fixtureName(serialNumber) + ".log");
+  m_metaPath = QDir(directory).filePath(interface::fixtureName(serialNumber) + ".meta");
+  m_lastLogIndex.head = 0;
+  m_lastLogIndex.tail = 0;
+  m_lastLogIndex.first = -1;
+}
+
+QString logStore::defaultDirectory(void) {
+  return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("logs");
+}
+
+// reads the history written by earlier sessions, false if it's unreadable
+bool logStore::load(void) {
+  QSettings meta(m_metaPath, QSettings::IniFormat);
+  m_nextIndex = meta.value("nextIndex", -1).toInt();
+  m_lastLogIndex.head = meta.value("head", 0).toInt();
+  m_lastLogIndex.tail = meta.value("tail", 0).toInt();
+  m_lastLogIndex.first = meta.value("first", -1).toInt();
+  m_entries.clear();
+  m_epoch = 0;
+  QFile file(m_logPath);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    return false;
+  }
+  while (!file.atEnd()) {
+    logEntry_t entry;
+    if (parseLine(file.readLine(), &entry)) {
+      m_entries.append(entry);
+    }
+  }
+  countEpochs(m_entries, 0);
+  return true;
+}
+
+// one "index uptime type valueSize value" line per entry, all hex, and
+// "#" lines marking where the fixture's log was reset or overwritten.
+// false for anything but an entry.
+bool logStore::parseLine(const QByteArray &line, logEntry_t *entry) {
+  QList<QByteArray> fields = line.trimmed().split(' ');
+  if ((fields.length() != 5) || fields.at(0).startsWith('#')) {
+    return false;
+  }
+  bool ok[5];
+  entry->index = fields.at(0).toInt(&ok[0], 16);
+  entry->uptime = fields.at(1).toUInt(&ok[1], 16);
+  entry->eventType = fields.at(2).toUShort(&ok[2], 16);
+  entry->valueSize = fields.at(3).toUShort(&ok[3], 16);
+  entry->value = fields.at(4).toULongLong(&ok[4], 16);
+  return ok[0] && ok[1] && ok[2] && ok[3] && ok[4];
+}
+
+QString logStore::logPath(void) {
+  return m_logPath;
+}
+
+// downloads the entries added since the last sync and appends them to the
+// store. when the last synced entry is no longer on the fixture, because the
+// log wrapped around or was reset, the whole log is downloaded again.
+QString logStore::sync(interface *iface, const logIndex_t &logIndex, int *numNewEntries) {
+  QVector<logEntry_t> newEntries;
+  QString note;
+  QString error;
+  int startIndex = logIndex.head;
+  int nextIndex;
+  bool verify = false;
+  *numNewEntries = 0;
+  if (m_nextIndex >= 0) {
+    if (!isOnFixture(m_nextIndex, logIndex)) {
+      note = QString("# log overwritten or reset before index %1").arg(toHexNum(m_nextIndex, 2));
+    } else if ((m_nextIndex != logIndex.head) && !m_entries.isEmpty()) {
+      // download the last stored entry again to check that it's still there
+      startIndex = (m_nextIndex - 1) & 0xFFFF;
+      verify = true;
+    } else {
+      startIndex = m_nextIndex;
+    }
+  }
+  error = eventLog::download(iface, startIndex, logIndex.tail, &newEntries, &nextIndex);
+  if (verify) {
+    if (!error.isEmpty() && newEntries.isEmpty()) {
+      return error;
+    }
+    if (!newEntries.isEmpty() && isSameEntry(newEntries.first(), m_entries.last())) {
+      newEntries.removeFirst();
+    } else {
+      // the log was reset and has grown past where we stopped
+      note = QString("# log reset before index %1").arg(toHexNum(m_nextIndex, 2));
+      newEntries.clear();
+      error = eventLog::download(iface, logIndex.head, logIndex.tail, &newEntries, &nextIndex);
+    }
+  }
+  if (!append(newEntries, note)) {
+    return QString("ERROR: Could not write %1").arg(QDir::toNativeSeparators(m_logPath));
+  }
+  *numNewEntries = newEntries.size();
+  m_nextIndex = nextIndex;
+  m_lastLogIndex = logIndex;
+  if (!saveMeta()) {
+    return QString("ERROR: Could not write %1").arg(QDir::toNativeSeparators(m_metaPath));
+  }
+  return error;
+}
+
+bool logStore::append(const QVector<logEntry_t> &entries, QString note) {
+  if (entries.isEmpty() && note.isEmpty()) {
+    return true;
+  }
+  QFile file(m_logPath);
+  if (!file.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+    return false;
+  }
+  QTextStream out(&file);
+  if (!note.isEmpty()) {
+    out << note << "\n";
+  }
+  foreach (const logEntry_t &entry, entries) {
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg(entry.index, 4, 16, QChar('0'))
+           .arg(entry.uptime, 8, 16, QChar('0'))
+           .arg(uint(entry.eventType), 2, 16, QChar('0'))
+           .arg(uint(entry.valueSize))
+           .arg(entry.value, 0, 16).toUpper();
+  }
+  out.flush();
+  countEpochs(entries, m_entries.isEmpty() ? 0 : m_entries.last().uptime);
+  m_entries += entries;
+  return (out.status() == QTextStream::Ok);
+}
+
+bool logStore::saveMeta(void) {
+  QSettings meta(m_metaPath, QSettings::IniFormat);
+  meta.setValue("nextIndex", m_nextIndex);
+  meta.setValue("head", m_lastLogIndex.head);
+  meta.setValue("tail", m_lastLogIndex.tail);
+  meta.setValue("first", m_lastLogIndex.first);
+  meta.setValue("lastSync", QDateTime::currentDateTime().toString(Qt::ISODate));
+  meta.sync();
+  return (meta.status() == QSettings::NoError);
+}
+
+// the stored entries fall into uptime epochs, numbered from 0, a new one
+// starting wherever the uptime goes back because the fixture was reset
+void logStore::countEpochs(const QVector<logEntry_t> &entries, quint32 previousUptime) {
+  foreach (const logEntry_t &entry, entries) {
+    if (entry.uptime < previousUptime) {
+      m_epoch++;
+    }
+    previousUptime = entry.uptime;
+  }
+}
+
+// the fixture's clock and uptime read at the same moment, which turn the
+// uptimes of the current epoch into wall clock time. every epoch keeps its
+// own reading, so the events from before a reset stay on the wall clock.
+bool logStore::saveAnchor(quint32 unixTime, quint32 uptime) {
+  int epoch = m_epoch;
+  if (!m_entries.isEmpty() && (uptime < m_entries.last().uptime)) {
+    // reset since its last event, the reading is for the events to come
+    epoch++;
+  }
+  QSettings meta(m_metaPath, QSettings::IniFormat);
+  meta.setValue(QString("anchors/%1/unixTime").arg(epoch), unixTime);
+  meta.setValue(QString("anchors/%1/uptime").arg(epoch), uptime);
+  meta.sync();
+  return (meta.status() == QSettings::NoError);
+}
+
+// wall clock time of uptime 0 of every epoch the fixture's clock was read
+// in, empty if it never was
+QHash<int, qint64> logStore::bootTimes(void) {
+  QHash<int, qint64> bootTimes;
+  QSettings meta(m_metaPath, QSettings::IniFormat);
+  meta.beginGroup("anchors");
+  foreach (const QString &group, meta.childGroups()) {
+    bool ok;
+    int epoch = group.toInt(&ok);
+    if (ok) {
+      quint32 unixTime = meta.value(group + "/unixTime").toUInt();
+      quint32 uptime = meta.value(group + "/uptime").toUInt();
+      bootTimes.insert(epoch, qint64(unixTime) - uptime);
+    }
+  }
+  meta.endGroup();
+  return bootTimes;
+}
+
+const QVector<logEntry_t> &logStore::entries(void) {
+  return m_entries;
+}
+
+int logStore::nextIndex(void) {
+  return m_nextIndex;
+}
+
+logIndex_t logStore::lastLogIndex(void) {
+  return m_lastLogIndex;
+}
@@ -0,0 +1,42 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "eventlog.h"
+
+class interface;
+
+// append-only history of the event log of one fixture, kept on disk so a
+// new session only has to download the entries added since the last sync
+class logStore
+{
+public:
+  explicit logStore(quint32 serialNumber, QString directory = QString());
+  bool load(void);
+  QString sync(interface *iface, const logIndex_t &logIndex, int *numNewEntries);
+  const QVector<logEntry_t> &entries(void);
+  int nextIndex(void);
+  logIndex_t lastLogIndex(void);
+  QString logPath(void);
+  bool saveAnchor(quint32 unixTime, quint32 uptime);
+  QHash<int, qint64> bootTimes(void);
+  static bool parseLine(const QByteArray &line, logEntry_t *entry);
+  static QString defaultDirectory(void);
+
+private:
+  QString m_logPath;
+  QString m_metaPath;
+  QVector<logEntry_t> m_entries;
+  // first log index not yet in the store, -1 before the first sync
+  int m_nextIndex;
+  logIndex_t m_lastLogIndex;
+  // uptime epoch of the last stored entry, see bootTimes()
+  int m_epoch;
+  bool append(const QVector<logEntry_t> &entries, QString note);
+  void countEpochs(const QVector<logEntry_t> &entries, quint32 previousUptime);
+  bool saveMeta(void);
+};
+
+#endif // LOGSTORE_H
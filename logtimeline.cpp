@@ -0,0 +1,131 @@
+#include "logtimeline.h"
+#include "logstore.h"
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+
+// events read from a log file at a time
+static const int s_chunkSize = 256;
+
+logTimeline::logTimeline(QString directory) :
+  m_directory(directory),
+  m_numSkipped(0) {
+}
+
+// adds the stored log of a fixture, synced with sync log. returns an error,
+// or an empty string once the fixture's first event is ready to merge.
+QString logTimeline::addFixture(quint32 serialNumber) {
+  logStore store(serialNumber, m_directory);
+  stream_t stream;
+  stream.serialNumber = serialNumber;
+  stream.bootTimes = store.bootTimes();
+  if (stream.bootTimes.isEmpty()) {
+    return "ERROR: The fixture's clock was never read, sync its log first";
+  }
+  stream.path = store.logPath();
+  QFile file(stream.path);
+  if (!file.exists()) {
+    return "ERROR: No log stored for the fixture";
+  }
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    return QString("ERROR: Could not read %1: %2").arg(QDir::toNativeSeparators(stream.path), file.errorString());
+  }
+  file.close();
+  stream.pos = 0;
+  stream.epoch = 0;
+  stream.uptime = 0;
+  if (!readNext(&stream)) {
+    // nothing to merge
+    return m_errors.isEmpty() ? QString() : m_errors.takeLast();
+  }
+  m_streams.append(stream);
+  m_heap.append(m_streams.size() - 1);
+  std::push_heap(m_heap.begin(), m_heap.end(), [this](int a, int b) { return isLater(a, b); });
+  return QString();
+}
+
+// the earliest event not returned yet, false once all streams are drained
+bool logTimeline::next(timelineEvent_t *event) {
+  auto later = [this](int a, int b) { return isLater(a, b); };
+  if (m_heap.isEmpty()) {
+    return false;
+  }
+  std::pop_heap(m_heap.begin(), m_heap.end(), later);
+  int i = m_heap.last();
+  *event = m_streams.at(i).head;
+  if (readNext(&m_streams[i])) {
+    std::push_heap(m_heap.begin(), m_heap.end(), later);
+  } else {
+    m_heap.removeLast();
+  }
+  return true;
+}
+
+// events of uptime epochs the fixture's clock was never read in, counted
+// as the merge goes past them
+int logTimeline::numSkipped(void) {
+  return m_numSkipped;
+}
+
+// logs that couldn't be read to the end during the merge. their events
+// up to there are merged.
+QStringList logTimeline::errors(void) {
+  return m_errors;
+}
+
+// std heaps put the largest element first, so the heap's "less" is "later".
+// ties go by serial number and log order, to keep the merge stable.
+bool logTimeline::isLater(int a, int b) const {
+  const timelineEvent_t &x = m_streams.at(a).head;
+  const timelineEvent_t &y = m_streams.at(b).head;
+  if (x.time != y.time) {
+    return x.time > y.time;
+  }
+  if (x.serialNumber != y.serialNumber) {
+    return x.serialNumber > y.serialNumber;
+  }
+  return x.entry.index > y.entry.index;
+}
+
+bool logTimeline::readNext(stream_t *stream) {
+  if (stream->buffered.isEmpty() && !readChunk(stream)) {
+    return false;
+  }
+  stream->head = stream->buffered.takeFirst();
+  return true;
+}
+
+// opens the log again, reads the next s_chunkSize events from where the
+// last chunk ended and closes it. the uptime going back starts the next
+// epoch, the events of an epoch without a clock reading are skipped.
+// false once there are no more.
+bool logTimeline::readChunk(stream_t *stream) {
+  if (stream->pos < 0) {
+    return false;
+  }
+  QFile file(stream->path);
+  if (!file.open(QFile::ReadOnly | QFile::Text) || !file.seek(stream->pos)) {
+    m_errors << QString("ERROR: Could not read %1: %2").arg(QDir::toNativeSeparators(stream->path), file.errorString());
+    stream->pos = -1;
+    return false;
+  }
+  while (!file.atEnd() && (stream->buffered.size() < s_chunkSize)) {
+    timelineEvent_t event;
+    if (!logStore::parseLine(file.readLine(), &event.entry)) {
+      continue;
+    }
+    if (event.entry.uptime < stream->uptime) {
+      stream->epoch++;
+    }
+    stream->uptime = event.entry.uptime;
+    if (!stream->bootTimes.contains(stream->epoch)) {
+      m_numSkipped++;
+      continue;
+    }
+    event.time = stream->bootTimes.value(stream->epoch) + event.entry.uptime;
+    event.serialNumber = stream->serialNumber;
+    stream->buffered << event;
+  }
+  stream->pos = file.atEnd() ? -1 : file.pos();
+  return !stream->buffered.isEmpty();
+}
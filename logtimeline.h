@@ -0,0 +1,59 @@
+#ifndef LOGTIMELINE_H
+#define LOGTIMELINE_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "eventlog.h"
+
+// a log entry placed on the wall clock
+struct timelineEvent_t {
+  // seconds since the epoch
+  qint64 time;
+  quint32 serialNumber;
+  logEntry_t entry;
+};
+
+// merges the stored logs of many fixtures into one stream ordered by wall
+// clock time. each uptime epoch of a log is placed with the clock reading
+// taken in it, see logStore::bootTimes(). only a few upcoming events of
+// every fixture are held in memory, the rest is read from the log store as
+// the merge goes. no file stays open between reads, so there can be more
+// fixtures than the open file limit allows.
+class logTimeline
+{
+public:
+  explicit logTimeline(QString directory = QString());
+  QString addFixture(quint32 serialNumber);
+  bool next(timelineEvent_t *event);
+  int numSkipped(void);
+  QStringList errors(void);
+
+private:
+  struct stream_t {
+    quint32 serialNumber;
+    // wall clock time of uptime 0, by uptime epoch
+    QHash<int, qint64> bootTimes;
+    QString path;
+    // where the next chunk starts, -1 past the end
+    qint64 pos;
+    // epoch and uptime of the last entry read
+    int epoch;
+    quint32 uptime;
+    QList<timelineEvent_t> buffered;
+    timelineEvent_t head;
+  };
+  QString m_directory;
+  QVector<stream_t> m_streams;
+  // m_streams positions, a min-heap on the time of their head event
+  QVector<int> m_heap;
+  int m_numSkipped;
+  QStringList m_errors;
+  bool readNext(stream_t *stream);
+  bool readChunk(stream_t *stream);
+  bool isLater(int a, int b) const;
+};
+
+#endif // LOGTIMELINE_H
@@ -1,7 +1,20 @@
 #include "mainwindow.h"
+#include "headless.h"
+#include "bench.h"
 #include <QApplication>
 
 int main(int argc, char *argv[]) {
+  if (benchRunner::isRequested(argc, argv)) {
+    QCoreApplication a(argc, argv);
+    benchRunner runner;
+    return runner.run(a.arguments());
+  }
+  if (headlessRunner::isRequested(argc, argv)) {
+    // scripted use: no widgets, stylesheets or driver checks
+    QCoreApplication a(argc, argv);
+    headlessRunner runner;
+    return runner.run(a.arguments());
+  }
   QApplication a(argc, argv);
   MainWindow w;
   w.show();
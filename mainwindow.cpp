@@ -2,6 +2,9 @@
 #include "ui_mainwindow.h"
 #include "interface.h"
 #include "solarized.h"
+#include <algorithm>
+#include <QAction>
+#include <QClipboard>
 #include <QDebug>
 #include <QFileDialog>
 #include <QKeyEvent>
@@ -18,35 +21,63 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
   m_interface(new interface::interface),
   m_preferencesDialog(new preferencesDialog::preferencesDialog) {
   ui->setupUi(this);
+  m_outputModel = new outputModel(m_preferencesDialog->m_scrollbackLines, this);
+  m_cmdWatch = new cmdWatch(m_interface, this);
+  m_sampleRecorder = NULL;
+  m_sessionLog = new sessionLog((sessionLog::format) m_preferencesDialog->m_sessionLogFormat);
   QApplication::setWindowIcon(QIcon(QString::fromUtf8(":/DL.png")));
   // remove the ugly focus border
   ui->commandLine->setAttribute(Qt::WA_MacShowFocusRect, 0);
   // set solarized theme
   solarized::setStyleSheetQLineEdit(ui->commandLine);
-  solarized::setStyleSheetQTextEdit(ui->outputFeed);
+  solarized::setStyleSheetQListView(ui->outputFeed);
   solarized::setStyleSheetQFrame(ui->line);
+  solarized::setStyleSheetQLineEdit(ui->searchLine);
   // configure GUI widgets
   ui->actionDisconnect->setVisible(false);
   // configure autocomplete
-  ui->commandLine->setCompleter(m_cmdHelper->m_cmdCompleter);
+  ui->commandLine->setCompleter(m_cmdHelper->completer());
   // catch command events
   ui->commandLine->installEventFilter(this);
   // default text before connection is established
   ui->commandLine->setPlaceholderText("Press ⌘K to establish a connection.");
+  // only the visible lines of the output are laid out and painted
+  ui->outputFeed->setModel(m_outputModel);
+  ui->outputFeed->setItemDelegate(new outputDelegate(ui->outputFeed));
+  ui->outputFeed->setUniformItemSizes(true);
+  ui->outputFeed->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  ui->outputFeed->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  QAction *copyAction = new QAction(tr("Copy"), ui->outputFeed);
+  connect(copyAction, SIGNAL(triggered()), this, SLOT(on_copyOutput()));
+  ui->outputFeed->addAction(copyAction);
+  ui->outputFeed->setContextMenuPolicy(Qt::ActionsContextMenu);
   // disable tab focus policy
   ui->outputFeed->setFocusPolicy(Qt::NoFocus);
+  // the search bar filters the output as you type, it stays hidden until ⌘F
+  ui->searchBar->setVisible(false);
+  ui->searchLine->setAttribute(Qt::WA_MacShowFocusRect, 0);
+  ui->searchLine->installEventFilter(this);
+  connect(ui->searchLine, SIGNAL(textChanged(QString)), this, SLOT(on_searchChanged()));
+  connect(ui->searchColor_comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(on_searchChanged()));
   // hint to OSX about the role of these menu items
   ui->actionAbout->setMenuRole(QAction::AboutRole);
   ui->actionPreferences->setMenuRole(QAction::PreferencesRole);
   // connect signals and slots
   connect(m_interface, SIGNAL(connectionEstablished()), this, SLOT(on_connectionEstablished()));
   connect(m_interface, SIGNAL(connectionStatusChanged(QString)), this, SLOT(on_connectionStatusChanged(QString)));
+  connect(m_interface, SIGNAL(requestFinished(int,QStringList)), this, SLOT(on_requestFinished(int,QStringList)));
+  connect(m_preferencesDialog, SIGNAL(accepted()), this, SLOT(on_preferencesAccepted()));
+  connect(m_cmdWatch, SIGNAL(sampleChanged(QStringList)), this, SLOT(on_watchSampleChanged(QStringList)));
+  connect(m_cmdWatch, SIGNAL(intervalChanged(int)), this, SLOT(on_watchIntervalChanged(int)));
   this->setWindowTitle("DLTerm");
   // install telegesis drivers if missing
   checkForInstalledKexts();
 }
 
 MainWindow::~MainWindow() {
+  m_interface->setRecorder(NULL);
+  delete m_sampleRecorder;
+  delete m_sessionLog;
   delete ui;
 }
 
@@ -76,53 +107,162 @@ void MainWindow::checkForInstalledKexts(void) {
   }
 }
 
-QString MainWindow::processUserRequest(QString *request) {
+void MainWindow::processUserRequest(QString request) {
   QStringList argList;
-  QStringList responseList;
-  QString preamble;
-  QString response;
-  if (request->startsWith("help")) {
-    solarized::setTextColor(request, solarized::SOLAR_YELLOW);
-    return buildAppHelp();
+  outputLine_t promptLine;
+  promptLine << buildPrompt();
+  if (request.startsWith("help")) {
+    // "help <topic>" selects a help page
+    QString topic = request.section(' ', 1, 1);
+    promptLine << outputSpan_t(request, solarized::SOLAR_YELLOW);
+    appendOutput(QList<outputLine_t>() << promptLine << buildAppHelp(topic) << outputLine_t());
+    return;
+  } else if (request.startsWith("watch")) {
+    processWatchRequest(request);
+    return;
+  } else if (request.startsWith("record")) {
+    processRecordRequest(request);
+    return;
   }
-  // check for a helper handler
-  cmdHandler_t handler = m_cmdHelper->getCmdHandler(*request);
-  if (handler == NULL) {
-    // not a helper command
-    responseList = m_interface->queryPmu(QStringList() << *request);
-    solarized::setTextColor(request, solarized::SOLAR_BASE_01);
+  bool useCache;
+  cmdHandler_t handler = m_cmdHelper->parseRequest(request, &argList, &useCache);
+  // run the request on the I/O thread so the GUI stays responsive
+  int requestId = m_interface->runAsync(handler, argList, useCache);
+  if (!handler) {
+    promptLine << outputSpan_t(request, solarized::SOLAR_BASE_01);
   } else {
-    argList = request->split(" ");
-    argList.removeFirst();
-    argList.removeFirst();
-    // pass control to the helper
-    responseList = handler(argList, m_interface);
-    solarized::setTextColor(request, solarized::SOLAR_YELLOW);
+    promptLine << outputSpan_t(request, solarized::SOLAR_YELLOW);
   }
+  // the prompt is printed together with the response once it arrives
+  m_pendingRequests.insert(requestId, promptLine);
+  updatePlaceholderText();
+}
+
+QList<outputLine_t> MainWindow::formatResponse(QStringList responseList) {
+  QList<outputLine_t> lines;
   // flatten
   foreach(QString r, responseList) {
+    solarized::solarizedColor color;
     if (r.contains("ERROR")) {
       // remove plus from parsed responses with errors
       if (r.startsWith("+")) {
         r.remove("+");
       }
-      solarized::setTextColor(&r, solarized::SOLAR_RED);
+      color = solarized::SOLAR_RED;
     } else if (r.startsWith("+")) {
       // parsed responses start with plus
       r.remove("+");
-      solarized::setTextColor(&r, solarized::SOLAR_BLUE);
+      color = solarized::SOLAR_BLUE;
     } else if (r.contains("OK")) {
-      solarized::setTextColor(&r, solarized::SOLAR_GREEN);
+      color = solarized::SOLAR_GREEN;
     } else {
       // unparsed responses
-      solarized::setTextColor(&r, solarized::SOLAR_VIOLET);
+      color = solarized::SOLAR_VIOLET;
+    }
+    // some helpers break their response into several lines
+    QStringList textList = r.split("<br>");
+    if ((textList.length() > 1) && textList.last().isEmpty()) {
+      textList.removeLast();
     }
-    response += (r + "<br>");
+    foreach (const QString &text, textList) {
+      lines << (outputLine_t() << outputSpan_t(text, color));
+    }
+  }
+  return lines;
+}
+
+void MainWindow::appendOutput(QList<outputLine_t> lines) {
+  m_outputModel->appendLines(lines);
+  // the pane only keeps the scrollback, the session log keeps everything
+  m_sessionLog->append(lines);
+  // always follow the newest output
+  ui->outputFeed->scrollToBottom();
+}
+
+void MainWindow::updatePlaceholderText(void) {
+  if (m_interface->isConnected() == false) {
+    ui->commandLine->setPlaceholderText("Press ⌘K to establish a connection.");
+  } else if (m_pendingRequests.isEmpty()) {
+    ui->commandLine->setPlaceholderText("Type a command here. Terminate by pressing ENTER.");
+  } else {
+    ui->commandLine->setPlaceholderText(QString("Waiting for %1 pending request(s)...").arg(m_pendingRequests.count()));
   }
-  return response;
 }
 
-QString MainWindow::buildPrompt(void) {
+// watch <seconds> <command> replaces any running watch, watch stop ends it
+void MainWindow::processWatchRequest(QString request) {
+  QList<outputLine_t> lines;
+  QStringList argList;
+  QString command;
+  int intervalMs;
+  bool useCache;
+  outputLine_t promptLine;
+  promptLine << buildPrompt() << outputSpan_t(request, solarized::SOLAR_YELLOW);
+  lines << promptLine;
+  if (request == "watch stop") {
+    m_cmdWatch->stop();
+    lines << (outputLine_t() << outputSpan_t("[Watch stopped]", solarized::SOLAR_BASE_01));
+  } else if (cmdWatch::parseRequest(request, &intervalMs, &command)) {
+    cmdHandler_t handler = m_cmdHelper->parseRequest(command, &argList, &useCache);
+    m_cmdWatch->start(intervalMs, handler, argList, useCache);
+    lines << (outputLine_t() << outputSpan_t("[Watching, only changes are shown. Type watch stop or press ESC to stop]",
+                                             solarized::SOLAR_BASE_01));
+  } else {
+    lines << (outputLine_t() << outputSpan_t("ERROR: Usage is watch <seconds> <command>", solarized::SOLAR_RED));
+  }
+  appendOutput(lines << outputLine_t());
+}
+
+// record start [directory] writes every read of the recorded registers to
+// disk until record stop
+void MainWindow::processRecordRequest(QString request) {
+  QList<outputLine_t> lines;
+  outputLine_t promptLine;
+  promptLine << buildPrompt() << outputSpan_t(request, solarized::SOLAR_YELLOW);
+  lines << promptLine;
+  QString action = request.section(' ', 1, 1);
+  if ((action == "start") || (action == "stop")) {
+    // stopping writes out the samples that are still buffered
+    m_interface->setRecorder(NULL);
+    delete m_sampleRecorder;
+    m_sampleRecorder = NULL;
+  }
+  if (action == "start") {
+    m_sampleRecorder = new sampleRecorder(request.section(' ', 2));
+    m_interface->setRecorder(m_sampleRecorder);
+    lines << (outputLine_t() << outputSpan_t(QString("[Recording temperature, current level, power and input voltage to %1]")
+                                             .arg(m_sampleRecorder->directory()), solarized::SOLAR_BASE_01));
+  } else if (action == "stop") {
+    lines << (outputLine_t() << outputSpan_t("[Recording stopped]", solarized::SOLAR_BASE_01));
+  } else {
+    lines << (outputLine_t() << outputSpan_t("ERROR: Usage is record start [directory] or record stop", solarized::SOLAR_RED));
+  }
+  appendOutput(lines << outputLine_t());
+}
+
+void MainWindow::on_watchSampleChanged(QStringList responseList) {
+  QString timestamp = QTime::currentTime().toString("HH:mm:ss.zzz");
+  outputLine_t timestampLine;
+  timestampLine << outputSpan_t(QString("[%1]").arg(timestamp), solarized::SOLAR_BASE_01);
+  appendOutput(QList<outputLine_t>() << timestampLine << formatResponse(responseList));
+}
+
+void MainWindow::on_watchIntervalChanged(int intervalMs) {
+  outputLine_t line;
+  line << outputSpan_t(QString("[Watch interval is now %1 s]").arg(intervalMs / 1000.0), solarized::SOLAR_BASE_01);
+  appendOutput(QList<outputLine_t>() << line);
+}
+
+void MainWindow::on_requestFinished(int requestId, QStringList responseList) {
+  // watch samples are handled by m_cmdWatch
+  if (!m_pendingRequests.contains(requestId)) {
+    return;
+  }
+  appendOutput(QList<outputLine_t>() << m_pendingRequests.take(requestId) << formatResponse(responseList) << outputLine_t());
+  updatePlaceholderText();
+}
+
+outputSpan_t MainWindow::buildPrompt(void) {
   QString prompt;
   QString timestamp;
   if (ui->actionShow_Timestamp->isChecked()) {
@@ -131,31 +271,31 @@ QString MainWindow::buildPrompt(void) {
   } else {
     prompt = " > ";
   }
-  solarized::setTextColor(&prompt, solarized::SOLAR_BASE_01);
-  return prompt;
+  return outputSpan_t(prompt, solarized::SOLAR_BASE_01);
 }
 
-QString MainWindow::buildAppHelp(void) {
-  QString response;
-  QStringList helpList = m_cmdHelper->help();
+QList<outputLine_t> MainWindow::buildAppHelp(QString topic) {
+  QList<outputLine_t> lines;
+  QStringList helpList = m_cmdHelper->help(topic);
   foreach(QString r, helpList) {
     if (r.startsWith("-")) {
-      solarized::setTextColor(&r, solarized::SOLAR_BASE_01);
+      lines << (outputLine_t() << outputSpan_t(r, solarized::SOLAR_BASE_01));
     } else {
-      solarized::setTextColor(&r, solarized::SOLAR_CYAN);
+      lines << (outputLine_t() << outputSpan_t(r, solarized::SOLAR_CYAN));
     }
-    response += (r + "<br>");
-  }
-  if (response.endsWith("<br>") == false) {
-    response += "<br>";
   }
-  return response;
+  return lines;
 }
 
 bool MainWindow::eventFilter(QObject *target, QEvent *event) {
   QString userRequest;
-  QString pmuResponse;
-  QString prompt;
+  if (target == ui->searchLine) {
+    if ((event->type() == QEvent::KeyPress) && (static_cast<QKeyEvent *>(event)->key() == Qt::Key_Escape)) {
+      hideSearch();
+      return true;
+    }
+    return QObject::eventFilter(target, event);
+  }
   if (event->type() == QEvent::KeyPress) {
     QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
     switch (keyEvent->key()) {
@@ -168,16 +308,10 @@ bool MainWindow::eventFilter(QObject *target, QEvent *event) {
         ui->commandLine->clear();
         break;
       }
-      // process the command
+      // process the command without blocking the GUI thread
       m_cmdHistory->append(userRequest);
-      prompt = buildPrompt();
-      pmuResponse = processUserRequest(&userRequest);
       ui->commandLine->clear();
-      ui->outputFeed->insertHtml(prompt + userRequest + "<br>");
-      ui->outputFeed->insertHtml(pmuResponse + "<br>");
-      // scroll to bottom
-      QCoreApplication::processEvents();
-      ui->outputFeed->verticalScrollBar()->setValue(ui->outputFeed->verticalScrollBar()->maximum());
+      processUserRequest(userRequest);
       break;
     case Qt::Key_Tab:
       if (ui->commandLine->cursorPosition() != m_cmdHelper->getCurrentCompletionLength()) {
@@ -199,6 +333,13 @@ bool MainWindow::eventFilter(QObject *target, QEvent *event) {
         ui->commandLine->clear();
       }
       break;
+    case Qt::Key_Escape:
+      if (m_cmdWatch->isActive()) {
+        processWatchRequest("watch stop");
+      } else if (m_interface->isConnecting()) {
+        m_interface->cancelConnect();
+      }
+      break;
     case Qt::Key_Home:
       ui->commandLine->home(false);
       break;
@@ -223,12 +364,14 @@ void MainWindow::on_actionConnect_Using_Telegesis_triggered() {
   }
   // check serial number again before connecting
   if (m_preferencesDialog->m_serialNumber != 0) {
-    m_interface->configure(m_preferencesDialog->m_networkStr, m_preferencesDialog->m_serialNumber);
+    m_interface->configure(m_preferencesDialog->m_networkStr, m_preferencesDialog->m_serialNumbers);
+    m_interface->setGateways(m_preferencesDialog->m_maxGateways);
     m_interface->connectTelegesis();
   }
 }
 
 void MainWindow::on_actionDisconnect_triggered() {
+  m_cmdWatch->stop();
   m_interface->disconnect();
   ui->actionDisconnect->setVisible(false);
   ui->actionConnect_Using_FTDI->setVisible(true);
@@ -242,33 +385,82 @@ void MainWindow::on_connectionEstablished(void) {
   ui->actionConnect_Using_Telegesis->setVisible(false);
   ui->actionDisconnect->setVisible(true);
   ui->actionPreferences->setDisabled(true);
-  ui->commandLine->setPlaceholderText("Type a command here. Terminate by pressing ENTER.");
+  updatePlaceholderText();
 }
 
 void MainWindow::on_connectionStatusChanged(QString status) {
-  QString response;
-  response = QString("[%1]").arg(status);
-  solarized::setTextColor(&response, solarized::SOLAR_BASE_01);
-  ui->outputFeed->insertHtml(QString("%1<br>").arg(response));
+  outputLine_t line;
+  line << outputSpan_t(QString("[%1]").arg(status), solarized::SOLAR_BASE_01);
+  appendOutput(QList<outputLine_t>() << line);
 }
 
 void MainWindow::on_actionClear_Output_triggered() {
-  ui->outputFeed->clear();
+  m_outputModel->clear();
+}
+
+void MainWindow::on_actionFind_triggered() {
+  ui->searchBar->setVisible(true);
+  ui->searchLine->setFocus();
+  ui->searchLine->selectAll();
+}
+
+// runs on every keystroke, the index keeps it cheap however long the history is
+void MainWindow::on_searchChanged() {
+  // the entries of searchColor_comboBox
+  static const quint32 colorMasks[] = {
+    0,
+    1 << solarized::SOLAR_RED,
+    1 << solarized::SOLAR_GREEN,
+    1 << solarized::SOLAR_BLUE,
+    1 << solarized::SOLAR_VIOLET
+  };
+  int colorIndex = qBound(0, ui->searchColor_comboBox->currentIndex(), 4);
+  m_outputModel->setFilter(ui->searchLine->text(), colorMasks[colorIndex]);
+  ui->outputFeed->scrollToBottom();
+}
+
+// shows the whole output again and hands the keyboard back to the command line
+void MainWindow::hideSearch(void) {
+  ui->searchBar->setVisible(false);
+  ui->searchLine->clear();
+  ui->searchColor_comboBox->setCurrentIndex(0);
+  m_outputModel->setFilter(QString());
+  ui->outputFeed->scrollToBottom();
+  ui->commandLine->setFocus();
 }
 
 void MainWindow::on_actionSave_Output_to_File_triggered() {
   QString filename = QFileDialog::getSaveFileName(this, tr("Save output"), QDir::currentPath(), tr("Text File (*.txt)"));
-  QFile file(filename);
-  if (file.open(QFile::WriteOnly | QFile::Truncate)) {
-    QTextStream out(&file);
-    out << ui->outputFeed->toPlainText();
+  // the whole session, including what scrolled out of the pane
+  if (!filename.isEmpty() && !m_sessionLog->saveTo(filename)) {
+    QMessageBox::critical(this, tr("Error"), tr("Failed to save the output to %1").arg(filename));
   }
 }
 
+void MainWindow::on_copyOutput() {
+  QStringList text;
+  QModelIndexList selection = ui->outputFeed->selectionModel()->selectedRows();
+  // in output order, not in the order the rows were clicked
+  std::sort(selection.begin(), selection.end());
+  foreach (const QModelIndex &index, selection) {
+    text << m_outputModel->lineText(index.row());
+  }
+  QApplication::clipboard()->setText(text.join("\n"));
+}
+
 void MainWindow::on_actionPreferences_triggered() {
   m_preferencesDialog->exec();
 }
 
+void MainWindow::on_preferencesAccepted() {
+  m_outputModel->setCapacity(m_preferencesDialog->m_scrollbackLines);
+  sessionLog::format sessionLogFormat = (sessionLog::format) m_preferencesDialog->m_sessionLogFormat;
+  if (sessionLogFormat != m_sessionLog->fileFormat()) {
+    // carry on in a new file of the same session
+    m_sessionLog->setFileFormat(sessionLogFormat);
+  }
+}
+
 void MainWindow::on_actionAbout_triggered() {
   QMessageBox::about(this, "About DLTerm",
                      tr("<p><b>Digital Lumens Terminal</b></p>"
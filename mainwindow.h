@@ -5,6 +5,10 @@
 #include "cmdhelper.h"
 #include "cmdhistory.h"
 #include "preferencesdialog.h"
+#include "outputmodel.h"
+#include "cmdwatch.h"
+#include "samplerecorder.h"
+#include "sessionlog.h"
 
 namespace Ui {
   class MainWindow;
@@ -17,6 +21,7 @@ class MainWindow : public QMainWindow
 public:
   explicit MainWindow(QWidget *parent = 0);
   ~MainWindow();
+  static QList<outputLine_t> formatResponse(QStringList responseList);
 
 public slots:
   void on_actionConnect_Using_FTDI_triggered();
@@ -28,18 +33,35 @@ public slots:
   void on_actionAbout_triggered();
   void on_connectionEstablished();
   void on_connectionStatusChanged(QString status);
+  void on_requestFinished(int requestId, QStringList responseList);
+  void on_preferencesAccepted();
+  void on_copyOutput();
+  void on_watchSampleChanged(QStringList responseList);
+  void on_watchIntervalChanged(int intervalMs);
+  void on_actionFind_triggered();
+  void on_searchChanged();
 
 private:
   Ui::MainWindow *ui;
   bool eventFilter(QObject *target, QEvent *event);
   void checkForInstalledKexts(void);
-  QString processUserRequest(QString *request);
-  QString buildPrompt(void);
-  QString buildAppHelp(void);
+  void processUserRequest(QString request);
+  void processWatchRequest(QString request);
+  void processRecordRequest(QString request);
+  void appendOutput(QList<outputLine_t> lines);
+  void updatePlaceholderText(void);
+  void hideSearch(void);
+  outputSpan_t buildPrompt(void);
+  QList<outputLine_t> buildAppHelp(QString topic);
   cmdHelper *m_cmdHelper;
   cmdHistory *m_cmdHistory;
   interface *m_interface;
   preferencesDialog *m_preferencesDialog;
+  outputModel *m_outputModel;
+  cmdWatch *m_cmdWatch;
+  sampleRecorder *m_sampleRecorder;
+  sessionLog *m_sessionLog;
+  QHash <int, outputLine_t> m_pendingRequests;
 };
 
 #endif // MAINWINDOW_H
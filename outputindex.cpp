@@ -0,0 +1,195 @@
+#include "outputindex.h"
+#include <QPair>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+// solarized has 16 colors
+static const int s_numColors = 16;
+
+static void appendId(QVector<qint64> *ids, qint64 id) {
+  // a word that shows up twice on a line is listed once
+  if (ids->isEmpty() || (ids->last() != id)) {
+    ids->append(id);
+  }
+}
+
+static QVector<qint64> intersect(const QVector<qint64> &a, const QVector<qint64> &b) {
+  QVector<qint64> result;
+  std::set_intersection(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(), std::back_inserter(result));
+  return result;
+}
+
+// all ids in any of the lists, sorted and without duplicates. the lists
+// are sorted already, so they're merged through a min-heap of their next ids
+static QVector<qint64> unite(const QList<const QVector<qint64> *> &lists) {
+  // next id of a list and the list
+  typedef QPair<qint64, int> head_t;
+  std::greater<head_t> later;
+  QVector<head_t> heap;
+  QVector<int> positions(lists.length(), 0);
+  QVector<qint64> result;
+  if (lists.length() == 1) {
+    return *lists.first();
+  }
+  for (int i = 0; i < lists.length(); i++) {
+    if (!lists.at(i)->isEmpty()) {
+      heap << head_t(lists.at(i)->first(), i);
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), later);
+  while (!heap.isEmpty()) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    head_t head = heap.last();
+    if (result.isEmpty() || (result.last() != head.first)) {
+      result << head.first;
+    }
+    int i = head.second;
+    if (++positions[i] < lists.at(i)->size()) {
+      heap.last() = head_t(lists.at(i)->at(positions[i]), i);
+      std::push_heap(heap.begin(), heap.end(), later);
+    } else {
+      heap.removeLast();
+    }
+  }
+  return result;
+}
+
+outputIndex::outputIndex() :
+  m_colors(s_numColors),
+  m_firstId(0),
+  m_numDropped(0) {
+}
+
+void outputIndex::add(qint64 id, const outputLine_t &line) {
+  foreach (const outputSpan_t &span, line) {
+    foreach (const QString &token, tokenize(span.text)) {
+      appendId(&m_tokens[token], id);
+    }
+    appendId(&m_colors[span.color], id);
+  }
+}
+
+// lines before id left the history. their ids are removed in bulk, once
+// there are enough of them to make it worth the pass over every list.
+void outputIndex::dropBefore(qint64 id) {
+  m_numDropped += id - m_firstId;
+  m_firstId = id;
+  if (m_numDropped > qMax<qint64>(4096, m_tokens.size())) {
+    compact();
+  }
+}
+
+void outputIndex::clear(void) {
+  m_tokens.clear();
+  m_colors = QVector<QVector<qint64> >(s_numColors);
+  m_numDropped = 0;
+}
+
+// the ids of the lines with a word starting with each of words and a span
+// in one of the colors of colorMask (bit n for color n, 0 for any color)
+QVector<qint64> outputIndex::find(const QStringList &words, quint32 colorMask) const {
+  QVector<qint64> result;
+  bool first = true;
+  foreach (const QString &word, words) {
+    // the last word is usually still being typed, so all words are prefixes
+    QList<const QVector<qint64> *> lists;
+    for (QMap<QString, QVector<qint64> >::const_iterator i = m_tokens.lowerBound(word);
+         (i != m_tokens.constEnd()) && i.key().startsWith(word); ++i) {
+      lists << &i.value();
+    }
+    if (lists.isEmpty()) {
+      return QVector<qint64>();
+    }
+    result = first ? unite(lists) : intersect(result, unite(lists));
+    first = false;
+  }
+  if (colorMask != 0) {
+    QList<const QVector<qint64> *> lists;
+    for (int color = 0; color < s_numColors; color++) {
+      if (colorMask & (1 << color)) {
+        lists << &m_colors.at(color);
+      }
+    }
+    result = first ? unite(lists) : intersect(result, unite(lists));
+  }
+  // leave out lines that are gone but not compacted away yet
+  result.erase(result.begin(), std::lower_bound(result.begin(), result.end(), m_firstId));
+  return result;
+}
+
+// lower case runs of letters and digits, e.g. "ERROR: FFFD" is error, fffd
+QStringList outputIndex::tokenize(const QString &text) {
+  QStringList tokens;
+  int start = -1;
+  for (int i = 0; i <= text.length(); i++) {
+    bool isWordChar = (i < text.length()) && text.at(i).isLetterOrNumber();
+    if (isWordChar && (start < 0)) {
+      start = i;
+    } else if (!isWordChar && (start >= 0)) {
+      tokens << text.mid(start, i - start).toLower();
+      start = -1;
+    }
+  }
+  return tokens;
+}
+
+// true if every line matching newWords and newColorMask also matches words
+// and colorMask, as when the query is typed on. the lines found for the
+// old query can then be narrowed with matches() instead of searching again.
+bool outputIndex::narrows(const QStringList &words, quint32 colorMask, const QStringList &newWords, quint32 newColorMask) {
+  if (newWords.length() < words.length()) {
+    return false;
+  }
+  for (int i = 0; i < words.length(); i++) {
+    if (!newWords.at(i).startsWith(words.at(i))) {
+      return false;
+    }
+  }
+  return (colorMask == 0) || ((newColorMask != 0) && ((newColorMask & ~colorMask) == 0));
+}
+
+// the same test as find(), for a single line that isn't indexed yet
+bool outputIndex::matches(const outputLine_t &line, const QStringList &words, quint32 colorMask) {
+  QStringList tokens;
+  bool colorMatches = (colorMask == 0);
+  foreach (const outputSpan_t &span, line) {
+    tokens << tokenize(span.text);
+    if (colorMask & (1 << span.color)) {
+      colorMatches = true;
+    }
+  }
+  if (!colorMatches) {
+    return false;
+  }
+  foreach (const QString &word, words) {
+    bool found = false;
+    foreach (const QString &token, tokens) {
+      if (token.startsWith(word)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void outputIndex::compact(void) {
+  for (QMap<QString, QVector<qint64> >::iterator i = m_tokens.begin(); i != m_tokens.end();) {
+    QVector<qint64> &ids = i.value();
+    ids.erase(ids.begin(), std::lower_bound(ids.begin(), ids.end(), m_firstId));
+    if (ids.isEmpty()) {
+      i = m_tokens.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  for (int color = 0; color < s_numColors; color++) {
+    QVector<qint64> &ids = m_colors[color];
+    ids.erase(ids.begin(), std::lower_bound(ids.begin(), ids.end(), m_firstId));
+  }
+  m_numDropped = 0;
+}
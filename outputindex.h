@@ -0,0 +1,34 @@
+#ifndef OUTPUTINDEX_H
+#define OUTPUTINDEX_H
+
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+#include "outputmodel.h"
+
+// the words and colors of every output line, each mapped to the ids of the
+// lines that have them. ids only grow, so every list stays sorted and a
+// search is a few lookups and merges, however long the history is.
+class outputIndex
+{
+public:
+  outputIndex();
+  void add(qint64 id, const outputLine_t &line);
+  void dropBefore(qint64 id);
+  void clear(void);
+  QVector<qint64> find(const QStringList &words, quint32 colorMask) const;
+  static QStringList tokenize(const QString &text);
+  static bool matches(const outputLine_t &line, const QStringList &words, quint32 colorMask);
+  static bool narrows(const QStringList &words, quint32 colorMask, const QStringList &newWords, quint32 newColorMask);
+
+private:
+  QMap<QString, QVector<qint64> > m_tokens;
+  // one list per solarized color
+  QVector<QVector<qint64> > m_colors;
+  // lines before this one are gone, but may still be in the lists
+  qint64 m_firstId;
+  int m_numDropped;
+  void compact(void);
+};
+
+#endif // OUTPUTINDEX_H
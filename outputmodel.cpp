@@ -0,0 +1,221 @@
+#include "outputmodel.h"
+#include <algorithm>
+#include <QFontMetrics>
+#include <QPainter>
+#include "outputindex.h"
+
+outputModel::outputModel(int capacity, QObject *parent) : QAbstractListModel(parent),
+  m_first(0),
+  m_count(0),
+  m_nextId(0),
+  m_index(new outputIndex()),
+  m_filtered(false),
+  m_filterColors(0) {
+  m_lines.resize(qMax(1, capacity));
+}
+
+outputModel::~outputModel() {
+  delete m_index;
+}
+
+int outputModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) {
+    return 0;
+  }
+  return m_filtered ? m_filteredIds.size() : m_count;
+}
+
+QVariant outputModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || (index.row() >= rowCount())) {
+    return QVariant();
+  }
+  if ((role == Qt::DisplayRole) || (role == Qt::ToolTipRole)) {
+    return lineText(index.row());
+  }
+  return QVariant();
+}
+
+const outputLine_t &outputModel::line(int row) const {
+  if (m_filtered) {
+    return lineById(m_filteredIds.at(row));
+  }
+  return m_lines.at((m_first + row) % m_lines.size());
+}
+
+QString outputModel::lineText(int row) const {
+  QString text;
+  foreach (const outputSpan_t &span, line(row)) {
+    text += span.text;
+  }
+  return text;
+}
+
+void outputModel::appendLines(const QList<outputLine_t> &lines) {
+  int numLines = qMin(lines.length(), m_lines.size());
+  int overflow = qMax(0, (m_count + numLines) - m_lines.size());
+  if (numLines == 0) {
+    return;
+  }
+  // drop the oldest lines to make room
+  if (overflow > 0) {
+    qint64 newFirstId = firstId() + overflow;
+    int numRows = overflow;
+    if (m_filtered) {
+      numRows = std::lower_bound(m_filteredIds.constBegin(), m_filteredIds.constEnd(), newFirstId) - m_filteredIds.constBegin();
+    }
+    if (numRows > 0) {
+      beginRemoveRows(QModelIndex(), 0, numRows - 1);
+    }
+    for (int i = 0; i < overflow; i++) {
+      m_lines[(m_first + i) % m_lines.size()].clear();
+    }
+    m_first = (m_first + overflow) % m_lines.size();
+    m_count -= overflow;
+    m_filteredIds.remove(0, m_filtered ? numRows : 0);
+    m_index->dropBefore(newFirstId);
+    if (numRows > 0) {
+      endRemoveRows();
+    }
+  }
+  // new lines only become rows when they pass the filter
+  QVector<qint64> newRows;
+  for (int i = lines.length() - numLines; i < lines.length(); i++) {
+    qint64 id = m_nextId + (i - (lines.length() - numLines));
+    if (!m_filtered || outputIndex::matches(lines.at(i), m_filterWords, m_filterColors)) {
+      newRows << id;
+    }
+  }
+  int row = rowCount();
+  if (!newRows.isEmpty()) {
+    beginInsertRows(QModelIndex(), row, row + newRows.size() - 1);
+  }
+  for (int i = lines.length() - numLines; i < lines.length(); i++) {
+    m_lines[(m_first + m_count) % m_lines.size()] = lines.at(i);
+    m_index->add(m_nextId, lines.at(i));
+    m_count++;
+    m_nextId++;
+  }
+  if (m_filtered) {
+    m_filteredIds += newRows;
+  }
+  if (!newRows.isEmpty()) {
+    endInsertRows();
+  }
+}
+
+void outputModel::clear(void) {
+  beginResetModel();
+  m_lines = QVector<outputLine_t>(m_lines.size());
+  m_first = 0;
+  m_count = 0;
+  m_index->clear();
+  m_index->dropBefore(m_nextId);
+  m_filteredIds.clear();
+  endResetModel();
+}
+
+int outputModel::capacity(void) const {
+  return m_lines.size();
+}
+
+// keeps the most recent lines that still fit
+void outputModel::setCapacity(int capacity) {
+  capacity = qMax(1, capacity);
+  if (capacity == m_lines.size()) {
+    return;
+  }
+  QVector<outputLine_t> lines(capacity);
+  int numLines = qMin(m_count, capacity);
+  beginResetModel();
+  for (int i = 0; i < numLines; i++) {
+    lines[i] = m_lines.at((m_first + m_count - numLines + i) % m_lines.size());
+  }
+  m_lines = lines;
+  m_first = 0;
+  m_count = numLines;
+  m_index->dropBefore(firstId());
+  if (m_filtered) {
+    m_filteredIds = m_index->find(m_filterWords, m_filterColors);
+  }
+  endResetModel();
+}
+
+// shows only the lines with words starting with every word of text and a
+// span in one of the colors of colorMask (bit n for solarized color n).
+// an empty text and mask shows everything again. while the text is typed
+// on, the rows of the previous filter are narrowed down instead of looking
+// everything up again.
+void outputModel::setFilter(QString text, quint32 colorMask) {
+  QStringList words = outputIndex::tokenize(text);
+  bool filtered = !words.isEmpty() || (colorMask != 0);
+  QVector<qint64> filteredIds;
+  if (!filtered && !m_filtered) {
+    return;
+  }
+  if (filtered && m_filtered && outputIndex::narrows(m_filterWords, m_filterColors, words, colorMask)) {
+    foreach (qint64 id, m_filteredIds) {
+      if (outputIndex::matches(lineById(id), words, colorMask)) {
+        filteredIds << id;
+      }
+    }
+  } else if (filtered) {
+    filteredIds = m_index->find(words, colorMask);
+  }
+  beginResetModel();
+  m_filtered = filtered;
+  m_filterWords = words;
+  m_filterColors = colorMask;
+  m_filteredIds = filteredIds;
+  endResetModel();
+}
+
+bool outputModel::isFiltered(void) const {
+  return m_filtered;
+}
+
+qint64 outputModel::firstId(void) const {
+  return m_nextId - m_count;
+}
+
+const outputLine_t &outputModel::lineById(qint64 id) const {
+  return m_lines.at((m_first + (id - firstId())) % m_lines.size());
+}
+
+outputDelegate::outputDelegate(QObject *parent) : QStyledItemDelegate(parent) {
+}
+
+void outputDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
+  const outputModel *model = qobject_cast<const outputModel *>(index.model());
+  if (model == NULL) {
+    QStyledItemDelegate::paint(painter, option, index);
+    return;
+  }
+  QFontMetrics fm(option.font);
+  QRect rect = option.rect;
+  painter->save();
+  if (option.state & QStyle::State_Selected) {
+    painter->fillRect(rect, option.palette.highlight());
+  }
+  painter->setFont(option.font);
+  painter->setClipRect(rect);
+  // long lines are cut off at the right edge, the tooltip has the full text
+  foreach (const outputSpan_t &span, model->line(index.row())) {
+    if (rect.left() >= option.rect.right()) {
+      break;
+    }
+    painter->setPen(solarized::color(span.color));
+    painter->drawText(rect, Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine, span.text);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    rect.setLeft(rect.left() + fm.horizontalAdvance(span.text));
+#else
+    rect.setLeft(rect.left() + fm.width(span.text));
+#endif
+  }
+  painter->restore();
+}
+
+QSize outputDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const {
+  (void) index;
+  // every line has the same height, so the view never has to measure the history
+  return QSize(option.rect.width(), QFontMetrics(option.font).lineSpacing());
+}
@@ -0,0 +1,70 @@
+#ifndef OUTPUTMODEL_H
+#define OUTPUTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QStyledItemDelegate>
+#include <QVector>
+#include "solarized.h"
+
+// a run of text in a single color
+struct outputSpan_t {
+  outputSpan_t() : color(solarized::SOLAR_BASE_02) {}
+  outputSpan_t(QString text, solarized::solarizedColor color) : text(text), color(color) {}
+  QString text;
+  solarized::solarizedColor color;
+};
+
+// one line of the output feed
+typedef QVector<outputSpan_t> outputLine_t;
+
+class outputIndex;
+
+// the output feed history, a ring buffer holding the most recent capacity()
+// lines. appending never touches older lines, so it costs the same no matter
+// how much history there is. with a filter set, only the matching lines are
+// rows.
+class outputModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  explicit outputModel(int capacity, QObject *parent = 0);
+  ~outputModel();
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+  const outputLine_t &line(int row) const;
+  QString lineText(int row) const;
+  void appendLines(const QList<outputLine_t> &lines);
+  void clear(void);
+  int capacity(void) const;
+  void setCapacity(int capacity);
+  void setFilter(QString text, quint32 colorMask = 0);
+  bool isFiltered(void) const;
+
+private:
+  QVector<outputLine_t> m_lines;
+  int m_first;
+  int m_count;
+  // id of the next line appended, ids are never reused
+  qint64 m_nextId;
+  outputIndex *m_index;
+  bool m_filtered;
+  QStringList m_filterWords;
+  quint32 m_filterColors;
+  // ids of the matching lines, one per row
+  QVector<qint64> m_filteredIds;
+  qint64 firstId(void) const;
+  const outputLine_t &lineById(qint64 id) const;
+};
+
+// paints the colored spans of a line, without building a text document
+class outputDelegate : public QStyledItemDelegate
+{
+  Q_OBJECT
+public:
+  explicit outputDelegate(QObject *parent = 0);
+  void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+  QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+};
+
+#endif // OUTPUTMODEL_H
@@ -0,0 +1,260 @@
+#include "pmuemulator.h"
+#include "registertable.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QThread>
+
+// oldest entries are dropped once the log holds this many
+static const int s_logCapacity = 2048;
+// longest K<index> response, in characters
+static const int s_maxSegmentLength = 64;
+
+static QString hex(quint64 value, int numBytes) {
+  return QString("%1").arg(value, numBytes * 2, 16, QChar('0')).toUpper();
+}
+
+static bool parseHex(const QString &text, quint64 *value) {
+  bool ok;
+  if (text.isEmpty() || (text.length() > 16)) {
+    return false;
+  }
+  *value = text.toULongLong(&ok, 16);
+  return ok;
+}
+
+pmuEmulator::pmuEmulator(quint32 serialNumber, emulatorConfig_t config) :
+  m_config(config),
+  m_random(config.seed),
+  m_logHead(0) {
+  // every register in the table reads as zero unless set below
+  for (int i = 0; i < registerTable::count(); i++) {
+    const registerDescriptor_t *reg = registerTable::at(i);
+    m_registers.insert(reg->address, hex(0, reg->width ? reg->width : 2));
+  }
+  m_registers.insert(0x0000, "02010B0F0715");  // firmware version 2.1.11 (7/21/15)
+  m_registers.insert(0x0002, hex(serialNumber, 4));
+  m_registers.insert(0x0004, "0C80");          // 25 C
+  m_registers.insert(0x001C, "0064");          // light level
+  m_registers.insert(0x001F, "0FA0");          // 4000 mW
+  // lightbar 00 and battery backup C0 answer R reads
+  m_i2cRegisters.insert(0x0000, "0001");
+  m_i2cRegisters.insert(0x0001, "0012");
+  m_i2cRegisters.insert(0x0002, "3456");
+  m_i2cRegisters.insert(0x0003, "0102");
+  m_i2cRegisters.insert(0x0004, "0300");
+  m_i2cRegisters.insert(0xC000, "0001");
+  m_i2cRegisters.insert(0xC001, "0034");
+  m_i2cRegisters.insert(0xC002, "5678");
+  m_i2cRegisters.insert(0xC003, "0104");
+  m_i2cRegisters.insert(0xC004, "0100");
+  // a log of a fixture that has been running for a while
+  quint32 uptime = 1000000;
+  for (int i = 0; i < m_config.numLogEntries; i++) {
+    int kind = std::uniform_int_distribution<int>(0, 99)(m_random);
+    uptime += std::uniform_int_distribution<int>(1, 600)(m_random);
+    if ((i % 50) == 0) {
+      appendLogEntry(uptime, 0x00, 1, 0x01);
+    } else if (kind < 80) {
+      appendLogEntry(uptime, 0x01, 1, std::uniform_int_distribution<int>(0, 7)(m_random));
+    } else if (kind < 90) {
+      appendLogEntry(uptime, 0x05, 1, std::uniform_int_distribution<int>(0, 3)(m_random));
+    } else {
+      appendLogEntry(uptime, 0x08, 1, std::uniform_int_distribution<int>(0, 13)(m_random));
+    }
+  }
+  m_bootTime = uptime + 1;
+  m_upTime.start();
+}
+
+// thread-safe. the latency is spent outside of the lock, so pipelined
+// commands overlap the way they do over the air.
+QString pmuEmulator::issueCommand(QString cmd) {
+  QString response;
+  int delayMs;
+  bool lost;
+  {
+    QMutexLocker locker(&m_lock);
+    delayMs = m_config.latencyMs;
+    if (m_config.jitterMs > 0) {
+      delayMs += std::uniform_int_distribution<int>(0, m_config.jitterMs)(m_random);
+    }
+    lost = (std::uniform_int_distribution<int>(0, 99)(m_random) < m_config.lossPercent);
+    if (!lost) {
+      QChar opcode = cmd.isEmpty() ? QChar() : cmd.at(0).toUpper();
+      if (opcode == 'G') {
+        response = readRegister(cmd);
+      } else if (opcode == 'S') {
+        response = writeRegister(cmd);
+      } else if (opcode == 'K') {
+        response = readLog(cmd);
+      } else if (opcode == 'E') {
+        response = insertLogEntry(cmd);
+      } else if (opcode == 'J') {
+        response = setLogIndex(cmd);
+      } else if (opcode == 'R') {
+        response = readI2CRegister(cmd);
+      } else if (opcode == '!') {
+        response = reset(cmd);
+      } else {
+        response = "ERROR: FFFF";
+      }
+    }
+  }
+  if (delayMs > 0) {
+    QThread::msleep(delayMs);
+  }
+  return lost ? QString("ERROR: No response") : response;
+}
+
+// Gnnnn
+QString pmuEmulator::readRegister(QString cmd) {
+  quint64 address;
+  if ((cmd.length() != 5) || !parseHex(cmd.mid(1), &address)) {
+    return "ERROR: FFFE";
+  }
+  if (address == 0x0003) {
+    return hex(QDateTime::currentDateTime().toTime_t(), 4);
+  } else if (address == 0x000C) {
+    return hex(upTime(), 4);
+  } else if (m_registers.contains(address)) {
+    return m_registers.value(address);
+  } else if (address < 0x0100) {
+    // registers the table doesn't name yet
+    return "0000";
+  }
+  return "ERROR: FFFD";
+}
+
+// Snnnn value
+QString pmuEmulator::writeRegister(QString cmd) {
+  quint64 address;
+  quint64 value;
+  if ((cmd.length() < 7) || (cmd.at(5) != ' ') || !parseHex(cmd.mid(1, 4), &address) || !parseHex(cmd.mid(6), &value)) {
+    return "ERROR: FFFE";
+  }
+  const registerDescriptor_t *reg = registerTable::find(address);
+  if (reg == NULL) {
+    if (address >= 0x0100) {
+      return "ERROR: FFFD";
+    }
+    m_registers.insert(address, cmd.mid(6).toUpper());
+    return "OK";
+  }
+  if (!(reg->access & REG_WRITE)) {
+    return "ERROR: FFFC";
+  }
+  if ((reg->width != 0) && ((cmd.length() - 6) > (reg->width * 2))) {
+    return "ERROR: FFFB";
+  }
+  m_registers.insert(address, reg->width ? hex(value, reg->width) : cmd.mid(6).toUpper());
+  return "OK";
+}
+
+// K for the head, tail and first power up index, K<index> for a log segment
+QString pmuEmulator::readLog(QString cmd) {
+  int tail = (m_logHead + m_log.size()) & 0xFFFF;
+  if (cmd.length() == 1) {
+    int first = 0xFFFF;
+    for (int i = m_log.size() - 1; i >= 0; i--) {
+      if ((m_log.at(i).eventType == 0x00) && (m_log.at(i).value == 0x01)) {
+        first = (m_logHead + i) & 0xFFFF;
+        break;
+      }
+    }
+    return hex(m_logHead, 2) + hex(tail, 2) + hex(first, 2);
+  }
+  quint64 index;
+  if ((cmd.length() != 5) || !parseHex(cmd.mid(1), &index)) {
+    return "ERROR: FFFE";
+  }
+  int offset = quint16(index - m_logHead);
+  if (offset >= m_log.size()) {
+    return "ERROR: FFF8";
+  }
+  // the first timestamp of a segment is absolute, the rest are deltas
+  QString segment;
+  quint32 baseTime = 0;
+  for (int i = offset; i < m_log.size(); i++) {
+    const logEntry_t &entry = m_log.at(i);
+    quint32 delta = entry.uptime - baseTime;
+    int uptimeSize = ((i == offset) || (delta > 0xFFFF)) ? 4 : ((delta > 0xFF) ? 2 : 1);
+    quint32 uptime = (uptimeSize == 4) ? entry.uptime : delta;
+    bool isLastEntry = (i == (m_log.size() - 1));
+    QString encoded = QString::number(uptimeSize | (isLastEntry ? 0x8 : 0), 16) +
+                      QString::number(entry.valueSize, 16) +
+                      hex(entry.eventType, 1) +
+                      hex(uptime, uptimeSize) +
+                      (entry.valueSize ? hex(entry.value, entry.valueSize) : QString());
+    if (!segment.isEmpty() && ((segment.length() + encoded.length()) > s_maxSegmentLength)) {
+      break;
+    }
+    segment += encoded.toUpper();
+    baseTime = entry.uptime;
+  }
+  return segment;
+}
+
+// E<type><value>
+QString pmuEmulator::insertLogEntry(QString cmd) {
+  quint64 eventType;
+  quint64 value = 0;
+  QString valueStr = cmd.mid(3);
+  if ((cmd.length() < 3) || !parseHex(cmd.mid(1, 2), &eventType) || ((valueStr.length() % 2) != 0) ||
+      (!valueStr.isEmpty() && !parseHex(valueStr, &value))) {
+    return "ERROR: FFFE";
+  }
+  appendLogEntry(upTime(), eventType, valueStr.length() / 2, value);
+  return "OK";
+}
+
+// J<index> empties the log and restarts it at index
+QString pmuEmulator::setLogIndex(QString cmd) {
+  quint64 index;
+  if ((cmd.length() != 5) || !parseHex(cmd.mid(1), &index)) {
+    return "ERROR: FFFE";
+  }
+  m_log.clear();
+  m_logHead = index;
+  return "OK";
+}
+
+// R<device><register>
+QString pmuEmulator::readI2CRegister(QString cmd) {
+  quint64 address;
+  if ((cmd.length() != 5) || !parseHex(cmd.mid(1), &address)) {
+    return "ERROR: FFFE";
+  }
+  int device = address >> 8;
+  if ((device != 0x00) && (device != 0xC0)) {
+    // nothing at that I2C address
+    return "ERROR: FFF5";
+  }
+  return m_i2cRegisters.value(address, "0000");
+}
+
+QString pmuEmulator::reset(QString cmd) {
+  if (cmd.toUpper() == "!K") {
+    // reset log
+    m_logHead = (m_logHead + m_log.size()) & 0xFFFF;
+    m_log.clear();
+  }
+  return "OK";
+}
+
+void pmuEmulator::appendLogEntry(quint32 uptime, quint8 eventType, quint8 valueSize, quint64 value) {
+  logEntry_t entry;
+  entry.index = (m_logHead + m_log.size()) & 0xFFFF;
+  entry.uptime = uptime;
+  entry.eventType = eventType;
+  entry.valueSize = valueSize;
+  entry.value = value;
+  m_log.append(entry);
+  if (m_log.size() > s_logCapacity) {
+    m_log.removeFirst();
+    m_logHead = (m_logHead + 1) & 0xFFFF;
+  }
+}
+
+quint32 pmuEmulator::upTime(void) {
+  return m_bootTime + (m_upTime.elapsed() / 1000);
+}
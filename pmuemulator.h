@@ -0,0 +1,56 @@
+#ifndef PMUEMULATOR_H
+#define PMUEMULATOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <random>
+#include "eventlog.h"
+
+struct emulatorConfig_t {
+  emulatorConfig_t() : latencyMs(0), jitterMs(0), lossPercent(0), seed(1), numLogEntries(200) {}
+  // time every command takes, plus up to jitterMs
+  int latencyMs;
+  int jitterMs;
+  // chance a command gets no response at all
+  int lossPercent;
+  // runs with the same seed see the same jitter, losses and log
+  quint32 seed;
+  // events in the log when the emulator starts
+  int numLogEntries;
+};
+
+// a PMU that lives in memory, answering the same command strings a real one
+// does: G/S registers, the K log, E log inserts, R lightbar and battery
+// backup reads and ! resets, with FFxx error codes. needs nothing from DLLib.
+class pmuEmulator
+{
+public:
+  explicit pmuEmulator(quint32 serialNumber, emulatorConfig_t config = emulatorConfig_t());
+  QString issueCommand(QString cmd);
+
+private:
+  QMutex m_lock;
+  emulatorConfig_t m_config;
+  std::mt19937 m_random;
+  QElapsedTimer m_upTime;
+  // uptime in seconds when the emulator was created
+  quint32 m_bootTime;
+  QHash<quint16, QString> m_registers;
+  QHash<quint16, QString> m_i2cRegisters;
+  QVector<logEntry_t> m_log;
+  int m_logHead;
+  QString readRegister(QString cmd);
+  QString writeRegister(QString cmd);
+  QString readLog(QString cmd);
+  QString insertLogEntry(QString cmd);
+  QString setLogIndex(QString cmd);
+  QString readI2CRegister(QString cmd);
+  QString reset(QString cmd);
+  void appendLogEntry(quint32 uptime, quint8 eventType, quint8 valueSize, quint64 value);
+  quint32 upTime(void);
+};
+
+#endif // PMUEMULATOR_H
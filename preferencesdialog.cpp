@@ -1,14 +1,19 @@
 #include "preferencesdialog.h"
 #include "ui_preferencesdialog.h"
 #include "dllib.h"
+#include "interface.h"
 
 preferencesDialog::preferencesDialog(QWidget *parent) :
   QDialog(parent),
+  m_serialNumber(0),
+  m_scrollbackLines(10000),
+  m_sessionLogFormat(0),
+  m_maxGateways(1),
   ui(new Ui::preferencesDialog)
 {
   ui->setupUi(this);
   createNetworkCombos(false);
-  ui->serialNumber_lineEdit->setPlaceholderText("0400BEEF");
+  ui->serialNumber_lineEdit->setPlaceholderText("0400BEEF, 0400BF00-0400BF0F");
 }
 
 preferencesDialog::~preferencesDialog()
@@ -36,11 +41,16 @@ void preferencesDialog::createNetworkCombos(const bool encryptionOn) {
 
 void preferencesDialog::accept() {
   bool ok;
-  m_serialNumber = ui->serialNumber_lineEdit->text().toULong(&ok, 16);
+  // one or more fixtures, all reached through the same gateway
+  m_serialNumbers = interface::parseSerialNumbers(ui->serialNumber_lineEdit->text(), &ok);
+  m_serialNumber = m_serialNumbers.isEmpty() ? 0 : m_serialNumbers.first();
   if (ui->netGroup_comboBox->currentIndex() == 0) {
     m_networkStr = LRNetwork::s_FactoryDefaultNwidStr;
   } else {
     m_networkStr = ui->netGroup_comboBox->currentText() + ui->netFreq_comboBox->currentText();
   }
+  m_scrollbackLines = ui->scrollback_spinBox->value();
+  m_sessionLogFormat = ui->sessionLog_comboBox->currentIndex();
+  m_maxGateways = ui->gateways_spinBox->value();
   QDialog::accept();
 }
@@ -17,6 +17,11 @@ public:
   void createNetworkCombos(const bool encryptionOn);
   QString m_networkStr;
   quint32 m_serialNumber;
+  QList<quint32> m_serialNumbers;
+  int m_scrollbackLines;
+  // a sessionLog::format
+  int m_sessionLogFormat;
+  int m_maxGateways;
 
 private slots:
   void accept();
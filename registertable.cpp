@@ -0,0 +1,235 @@
+#include "registertable.h"
+#include "cmdhelper.h"
+#include "interface.h"
+
+/*** decoders ***/
+static QString decode_firmwareVersion(QString response) {
+  bool ok;
+  qulonglong verInt = response.toULongLong(&ok, 16);
+  // format verMajor.verMinor.verBuild (buildMonth/buildDay/BuildYear)
+  return QString("+%1.%2.%3 (%5/%6/%4)").arg((verInt >> 40) & 0xFF).arg((verInt >> 32) & 0xFF).arg((verInt >> 24) & 0xFF).arg((verInt >> 16) & 0xFF).arg((verInt >> 8) & 0xFF).arg(verInt & 0xFF);
+}
+
+static QString decode_temperature(QString response) {
+  bool ok;
+  quint16 tInt = response.toUShort(&ok, 16);
+  float tFloat = (tInt / 128);
+  return QString("+%1 C").arg(tFloat);
+}
+
+static QString decode_upTime(QString response) {
+  return QString("+%1").arg(toYDHMS(response));
+}
+
+static QString decode_powerConsumption(QString response) {
+  bool ok;
+  quint16 powerInt = response.toUShort(&ok, 16);
+  return QString("+%1 mW").arg(powerInt);
+}
+
+/*** PMU registers, sorted by address ***/
+static constexpr registerDescriptor_t s_registerTable[] = {
+  { "firmwareVersion", 0x0000, 6, REG_READ, decode_firmwareVersion },
+  { "productCode", 0x0001, 0, REG_READ_WRITE, NULL },
+  { "serialNumber", 0x0002, 4, REG_READ_WRITE, NULL },
+  { "unixTime", 0x0003, 4, REG_READ_WRITE, NULL },
+  { "temperature", 0x0004, 2, REG_READ, decode_temperature },
+  { "lightManualLevel", 0x0005, 0, REG_WRITE, NULL },
+  { "lightOverrideActiveLevel", 0x0008, 0, REG_WRITE, NULL },
+  { "lightOverrideInactiveLevel", 0x0009, 0, REG_WRITE, NULL },
+  { "sensorDelayTime", 0x000A, 0, REG_READ, NULL },
+  { "sensorOverrideDelayTime", 0x000B, 0, REG_READ_WRITE, NULL },
+  { "upTime", 0x000C, 4, REG_READ, decode_upTime },
+  { "numLogEntries", 0x0015, 0, REG_READ, NULL },
+  { "configCalibrationP0", 0x0016, 0, REG_WRITE, NULL },
+  { "configCalibrationP1", 0x0017, 0, REG_WRITE, NULL },
+  { "configCalibrationP2", 0x0018, 0, REG_WRITE, NULL },
+  { "configCalibrationP3", 0x0019, 0, REG_WRITE, NULL },
+  { "buildTime", 0x001A, 0, REG_READ_WRITE, NULL },
+  { "sensorTimeoutCountdown", 0x001B, 0, REG_READ, NULL },
+  { "currentLightLevel", 0x001C, 0, REG_READ, NULL },
+  { "safeMode", 0x001D, 0, REG_READ, NULL },
+  { "lightBarSelect", 0x001E, 0, REG_READ_WRITE, NULL },
+  { "powerConsumption", 0x001F, 2, REG_READ, decode_powerConsumption },
+  { "wirelessDataAggregator", 0x0020, 0, REG_READ_WRITE, NULL },
+  { "resetUsageTimestamp", 0x0021, 0, REG_READ, NULL },
+  { "pwmPeriodRegister", 0x0022, 0, REG_READ_WRITE, NULL },
+  { "analogSensorValue", 0x0023, 0, REG_READ, NULL },
+  { "analogReportingHysteresis", 0x0024, 0, REG_READ, NULL },
+  { "zone", 0x0025, 0, REG_READ_WRITE, NULL },
+  { "lightTemporaryActiveLevel", 0x0026, 0, REG_READ_WRITE, NULL },
+  { "lightTemporaryInactiveLevel", 0x0027, 0, REG_READ_WRITE, NULL },
+  { "sensorTemporaryDelayTime", 0x0028, 0, REG_READ_WRITE, NULL },
+  { "temporaryOverrideTimeout", 0x0029, 0, REG_READ_WRITE, NULL },
+  { "setRemoteState", 0x002A, 0, REG_READ_WRITE, NULL },
+  { "remoteSetDelayTime", 0x002B, 0, REG_READ_WRITE, NULL },
+  { "remoteSecondsCountdown", 0x002C, 0, REG_READ, NULL },
+  { "minimumDimmingValue", 0x002D, 0, REG_READ, NULL },
+  { "powerCalibrationA0", 0x002E, 0, REG_WRITE, NULL },
+  { "powerCalibrationB0", 0x002F, 0, REG_WRITE, NULL },
+  { "powerCalibrationC0", 0x0030, 0, REG_WRITE, NULL },
+  { "powerCalibrationMA", 0x0031, 0, REG_WRITE, NULL },
+  { "powerCalibrationMB", 0x0032, 0, REG_WRITE, NULL },
+  { "powerCalibrationMC", 0x0033, 0, REG_WRITE, NULL },
+  { "powerCalibrationPOff", 0x0034, 0, REG_WRITE, NULL },
+  { "powerCalibrationPOn", 0x0035, 0, REG_WRITE, NULL },
+  { "powerCalibrationT0", 0x0036, 0, REG_WRITE, NULL },
+  { "powerEstimatorTemperatureOverride", 0x0037, 0, REG_READ_WRITE, NULL },
+  { "cachedTemperatureValue", 0x0038, 0, REG_READ, NULL },
+  { "eepromSize", 0x0039, 0, REG_READ, NULL },
+  { "hardwareRevision", 0x003A, 0, REG_READ, NULL },
+  { "wirelessPanId", 0x003B, 8, REG_WRITE, NULL },
+  { "wirelessChannelMask", 0x003C, 4, REG_WRITE, NULL },
+  { "wirelessShortAddress", 0x003D, 0, REG_WRITE, NULL },
+  { "wirelessRole", 0x003E, 0, REG_WRITE, NULL },
+  { "wirelessWatchdogHold", 0x003F, 0, REG_WRITE, NULL },
+  { "wirelessWatchdogPeriod", 0x0040, 0, REG_WRITE, NULL },
+  { "firmwareCode", 0x0041, 0, REG_READ, NULL },
+  { "moduleFirmwareCode", 0x0042, 0, REG_READ, NULL },
+  { "overTemperatureThresholdLow", 0x0045, 0, REG_WRITE, NULL },
+  { "overTemperatureThresholdHigh", 0x0046, 0, REG_READ_WRITE, NULL },
+  { "overTemperatureDimmingLimit", 0x0047, 0, REG_WRITE, NULL },
+  { "analogDimmingMode", 0x0048, 0, REG_READ_WRITE, NULL },
+  { "fixtureIdMode", 0x0049, 0, REG_READ_WRITE, NULL },
+  { "acFrequency", 0x004A, 0, REG_READ, NULL },
+  { "sensorBits", 0x004B, 0, REG_READ, NULL },
+  { "powerMeterCommand", 0x004C, 0, REG_READ_WRITE, NULL },
+  { "powerMeterRegister", 0x004D, 0, REG_READ_WRITE, NULL },
+  { "ambientTemperature", 0x004E, 0, REG_READ, NULL },
+  { "lightSensorLevel", 0x004F, 0, REG_READ, NULL },
+  { "sensor0Timeout", 0x0050, 0, REG_WRITE, NULL },
+  { "sensor0Offset", 0x0051, 0, REG_READ_WRITE, NULL },
+  { "sensor1Timeout", 0x0052, 0, REG_READ_WRITE, NULL },
+  { "sensor1Offset", 0x0053, 0, REG_READ_WRITE, NULL },
+  { "analogDimmingLowValue", 0x0054, 0, REG_WRITE, NULL },
+  { "analogDimmingHighValue", 0x0055, 0, REG_READ_WRITE, NULL },
+  { "analogDimmingOffValue", 0x0056, 0, REG_READ_WRITE, NULL },
+  { "powerMeasurementMode", 0x0057, 0, REG_READ_WRITE, NULL },
+  { "externalPowerMeter", 0x0058, 0, REG_READ_WRITE, NULL },
+  { "ambientSensorValue", 0x0059, 0, REG_READ, NULL },
+  { "ambientActiveLevel", 0x005A, 0, REG_WRITE, NULL },
+  { "ambientInactiveLevel", 0x005B, 0, REG_READ_WRITE, NULL },
+  { "ambientEnvironmentalGain", 0x005C, 0, REG_READ_WRITE, NULL },
+  { "ambientOffHysteresis", 0x005D, 0, REG_READ_WRITE, NULL },
+  { "ambientOnHysteresis", 0x005E, 0, REG_READ_WRITE, NULL },
+  { "powerboardProtocol", 0x005F, 0, REG_READ, NULL },
+  { "ledOverride", 0x0060, 0, REG_READ_WRITE, NULL },
+  { "fadeUpStep", 0x0061, 0, REG_READ_WRITE, NULL },
+  { "fadeDownStep", 0x0062, 0, REG_READ_WRITE, NULL },
+  { "maxBrightness", 0x0063, 0, REG_READ_WRITE, NULL },
+  { "i2cResets", 0x0064, 0, REG_READ, NULL },
+  { "sensorGuardTime", 0x0065, 0, REG_READ_WRITE, NULL },
+  { "inputVoltage", 0x0066, 0, REG_READ, NULL },
+  { "inputVoltageCalibration", 0x0067, 0, REG_READ_WRITE, NULL },
+  { "numLightbars", 0x0068, 0, REG_READ_WRITE, NULL },
+  { "currentLimit", 0x006A, 0, REG_READ_WRITE, NULL },
+  { "bootloaderCode", 0x006B, 0, REG_READ, NULL },
+  { "xpressMode", 0x006C, 0, REG_READ_WRITE, NULL },
+  { "batteryBackupStatus", 0x006D, 0, REG_WRITE, NULL },
+  { "sensorSeconds", 0x006E, 0, REG_READ, NULL },
+  { "inputVoltageTwo", 0x006F, 0, REG_READ, NULL },
+  { "inputVoltageTwoCalibration", 0x0070, 0, REG_READ_WRITE, NULL },
+  { "maxRampUpSpeed", 0x0071, 0, REG_READ_WRITE, NULL },
+  { "maxRampDownSpeed", 0x0072, 0, REG_READ_WRITE, NULL },
+  { "wirelessNetworkKey", 0x0073, 0, REG_WRITE, NULL },
+  { "emergencyLightLevel", 0x0074, 0, REG_READ, NULL },
+  { "batteryBackupPowerCalibration", 0x0075, 0, REG_READ_WRITE, NULL },
+  { "motionSensorProfile", 0x0076, 0, REG_READ_WRITE, NULL },
+  { "powerMeterLevelAtOff", 0x0077, 0, REG_WRITE, NULL },
+  { "powerMeterLevelAtMin", 0x0078, 0, REG_WRITE, NULL },
+  { "powerMeterLevelAtMax", 0x0079, 0, REG_WRITE, NULL },
+  { "powerMeterType", 0x007A, 0, REG_WRITE, NULL },
+  { "DLAiSlaveMode", 0x007B, 0, REG_READ_WRITE, NULL },
+  { "DALIBootloadingActive", 0x007C, 0, REG_READ, NULL },
+  { "testingMode", 0x007D, 0, REG_READ_WRITE, NULL },
+  { "numBatteriesSupported", 0x007E, 0, REG_READ_WRITE, NULL },
+};
+
+static constexpr int s_registerCount = sizeof(s_registerTable) / sizeof(s_registerTable[0]);
+
+static constexpr bool isSortedFrom(int i) {
+  return ((i + 1) >= s_registerCount) ||
+         ((s_registerTable[i].address < s_registerTable[i + 1].address) && isSortedFrom(i + 1));
+}
+
+// find() relies on this for its binary search
+static_assert(isSortedFrom(0), "s_registerTable must be sorted by address without duplicates");
+
+int registerTable::count(void) {
+  return s_registerCount;
+}
+
+const registerDescriptor_t *registerTable::at(int index) {
+  return &s_registerTable[index];
+}
+
+const registerDescriptor_t *registerTable::find(quint16 address) {
+  int lo = 0;
+  int hi = s_registerCount - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (s_registerTable[mid].address == address) {
+      return &s_registerTable[mid];
+    } else if (s_registerTable[mid].address < address) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
+}
+
+QString registerTable::readCommand(const registerDescriptor_t *reg) {
+  return QString("G%1").arg(reg->address, 4, 16, QChar('0')).toUpper();
+}
+
+QString registerTable::writeCommand(const registerDescriptor_t *reg, QString value) {
+  return QString("S%1 %2").arg(reg->address, 4, 16, QChar('0')).toUpper().arg(value);
+}
+
+bool registerTable::isValidValue(const registerDescriptor_t *reg, QString value) {
+  if (reg->width == 0) {
+    // let the fixture decide
+    return true;
+  }
+  bool ok;
+  value.toULongLong(&ok, 16);
+  return ok && (value.length() <= (reg->width * 2));
+}
+
+QStringList registerTable::read(const registerDescriptor_t *reg, QStringList argList, interface *iface) {
+  QStringList responseList;
+  (void) argList;
+  responseList = iface->queryPmu(QStringList() << readCommand(reg));
+  if ((reg->decoder == NULL) || responseList.at(0).startsWith("ERROR")) {
+    return responseList;
+  }
+  return QStringList() << reg->decoder(responseList.at(0));
+}
+
+QStringList registerTable::write(const registerDescriptor_t *reg, QStringList argList, interface *iface) {
+  if (argList.length() == 0) {
+    return QStringList() << "ERROR: expected a value";
+  }
+  if (!isValidValue(reg, argList.at(0))) {
+    return QStringList() << QString("ERROR: expected a hex value of at most %1 bytes").arg(reg->width);
+  }
+  return iface->queryPmu(QStringList() << writeCommand(reg, argList.at(0)));
+}
+
+QStringList registerTable::help(void) {
+  QStringList helpList;
+  for (int i = 0; i < s_registerCount; i++) {
+    const registerDescriptor_t *reg = &s_registerTable[i];
+    QString verbs;
+    if (reg->access == REG_READ_WRITE) {
+      verbs = "get, set";
+    } else if (reg->access == REG_READ) {
+      verbs = "get";
+    } else {
+      verbs = "set";
+    }
+    helpList << QString("- %1 (%2, %3)").arg(reg->name).arg(readCommand(reg)).arg(verbs);
+  }
+  return helpList;
+}
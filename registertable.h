@@ -0,0 +1,45 @@
+#ifndef REGISTERTABLE_H
+#define REGISTERTABLE_H
+
+#include <QString>
+#include <QStringList>
+
+class interface;
+
+// turns a successful register read into a parsed "+..." response
+typedef QString(*registerDecoder_t)(QString response);
+
+enum registerAccess {
+  REG_READ = 1,
+  REG_WRITE = 2,
+  REG_READ_WRITE = REG_READ | REG_WRITE
+};
+
+struct registerDescriptor_t {
+  // helper object name, as in "get <name>" or "set <name>"
+  const char *name;
+  // register number used in the Gnnnn and Snnnn commands
+  quint16 address;
+  // size in bytes, or 0 when writes shouldn't be length checked
+  quint8 width;
+  // which of the get and set helpers exist for this register
+  registerAccess access;
+  // NULL to show the raw hex value
+  registerDecoder_t decoder;
+};
+
+class registerTable
+{
+public:
+  static int count(void);
+  static const registerDescriptor_t *at(int index);
+  static const registerDescriptor_t *find(quint16 address);
+  static QString readCommand(const registerDescriptor_t *reg);
+  static QString writeCommand(const registerDescriptor_t *reg, QString value);
+  static bool isValidValue(const registerDescriptor_t *reg, QString value);
+  static QStringList read(const registerDescriptor_t *reg, QStringList argList, interface *iface);
+  static QStringList write(const registerDescriptor_t *reg, QStringList argList, interface *iface);
+  static QStringList help(void);
+};
+
+#endif // REGISTERTABLE_H
@@ -0,0 +1,223 @@
+#include "samplerecorder.h"
+#include <QDateTime>
+#include <QDir>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+// a file starts with "DLTS" and a version byte, followed by blocks of:
+//   varint length of the rest of the block
+//   varint serial number, varint register address, varint number of samples
+//   timestamps: zigzag varint of the first, then zigzag varint deltas
+//   values: zigzag varint of the first, then zigzag varint deltas
+// a block cut short by a crash is ignored when the file is loaded
+static const char s_magic[] = "DLTS";
+static const char s_version = 1;
+// a series is written out when it holds this many samples...
+static const int s_maxBlockSamples = 256;
+// ...or when its oldest sample is this old, so a crash loses little
+static const qint64 s_maxBlockAgeMs = 60000;
+
+static quint64 seriesKey(quint32 serialNumber, quint16 address) {
+  return (quint64(serialNumber) << 16) | address;
+}
+
+static quint64 zigzag(qint64 n) {
+  return (quint64(n) << 1) ^ quint64(n >> 63);
+}
+
+static qint64 unzigzag(quint64 n) {
+  return qint64(n >> 1) ^ -qint64(n & 1);
+}
+
+static void putVarint(QByteArray *out, quint64 n) {
+  while (n >= 0x80) {
+    out->append(char((n & 0x7F) | 0x80));
+    n >>= 7;
+  }
+  out->append(char(n));
+}
+
+static bool getVarint(const char **cursor, const char *end, quint64 *n) {
+  *n = 0;
+  for (int shift = 0; (*cursor < end) && (shift < 64); shift += 7) {
+    quint8 byte = **cursor;
+    (*cursor)++;
+    *n |= quint64(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void putColumn(QByteArray *out, const QVector<qint64> &column) {
+  qint64 previous = 0;
+  foreach (qint64 value, column) {
+    putVarint(out, zigzag(value - previous));
+    previous = value;
+  }
+}
+
+static bool getColumn(const char **cursor, const char *end, int count, QVector<qint64> *column) {
+  qint64 previous = 0;
+  quint64 n;
+  for (int i = 0; i < count; i++) {
+    if (!getVarint(cursor, end, &n)) {
+      return false;
+    }
+    previous += unzigzag(n);
+    column->append(previous);
+  }
+  return true;
+}
+
+sampleRecorder::sampleRecorder(QString directory, qint64 maxFileBytes) :
+  m_directory(directory.isEmpty() ? defaultDirectory() : directory),
+  m_maxFileBytes(maxFileBytes) {
+  // temperature, current level, power and input voltage
+  m_addresses << 0x0004 << 0x001C << 0x001F << 0x0066;
+}
+
+sampleRecorder::~sampleRecorder() {
+  flush();
+}
+
+QString sampleRecorder::defaultDirectory(void) {
+  return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("samples");
+}
+
+QString sampleRecorder::directory(void) {
+  return m_directory;
+}
+
+void sampleRecorder::setRegisters(QList<quint16> addresses) {
+  QMutexLocker locker(&m_lock);
+  m_addresses = addresses;
+}
+
+bool sampleRecorder::isRecorded(quint16 address) {
+  QMutexLocker locker(&m_lock);
+  return m_addresses.contains(address);
+}
+
+// keeps a register read if it's one of the recorded registers and the
+// response is a plain hex value
+void sampleRecorder::record(quint32 serialNumber, quint16 address, qint64 timestamp, QString response) {
+  bool ok;
+  if (response.isEmpty() || (response.length() > 16)) {
+    return;
+  }
+  qint64 value = response.toULongLong(&ok, 16);
+  if (!ok) {
+    return;
+  }
+  QMutexLocker locker(&m_lock);
+  if (!m_addresses.contains(address)) {
+    return;
+  }
+  sampleSeries_t &series = m_pending[seriesKey(serialNumber, address)];
+  if (series.timestamps.isEmpty()) {
+    series.serialNumber = serialNumber;
+    series.address = address;
+  }
+  series.timestamps.append(timestamp);
+  series.values.append(value);
+  if ((series.timestamps.length() >= s_maxBlockSamples) || ((timestamp - series.timestamps.first()) >= s_maxBlockAgeMs)) {
+    flushSeries(&series);
+  }
+}
+
+void sampleRecorder::flush(void) {
+  QMutexLocker locker(&m_lock);
+  for (QHash<quint64, sampleSeries_t>::iterator i = m_pending.begin(); i != m_pending.end(); ++i) {
+    flushSeries(&i.value());
+  }
+  if (m_file.isOpen()) {
+    m_file.flush();
+  }
+}
+
+// writes a series as one block and empties it. called with m_lock held.
+void sampleRecorder::flushSeries(sampleSeries_t *series) {
+  if (series->timestamps.isEmpty() || !openFile()) {
+    return;
+  }
+  QByteArray payload;
+  putVarint(&payload, series->serialNumber);
+  putVarint(&payload, series->address);
+  putVarint(&payload, series->timestamps.length());
+  putColumn(&payload, series->timestamps);
+  putColumn(&payload, series->values);
+  QByteArray block;
+  putVarint(&block, payload.length());
+  block.append(payload);
+  m_file.write(block);
+  series->timestamps.clear();
+  series->values.clear();
+}
+
+// opens a new file when there is none yet or the current one is full
+bool sampleRecorder::openFile(void) {
+  if (m_file.isOpen() && (m_file.size() < m_maxFileBytes)) {
+    return true;
+  }
+  m_file.close();
+  QDir().mkpath(m_directory);
+  QString name = QString("samples-%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+  QString path = QDir(m_directory).filePath(name + ".dlts");
+  for (int i = 1; QFile::exists(path); i++) {
+    path = QDir(m_directory).filePath(QString("%1-%2.dlts").arg(name).arg(i));
+  }
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    return false;
+  }
+  m_file.write(s_magic, 4);
+  m_file.write(&s_version, 1);
+  return true;
+}
+
+// reads a file written by a recorder, merging the blocks of every register
+// and fixture into one series each. false if it isn't a sample file.
+bool sampleRecorder::load(QString path, QList<sampleSeries_t> *seriesList) {
+  QFile file(path);
+  QHash<quint64, int> seriesIndex;
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QByteArray data = file.readAll();
+  if (!data.startsWith(s_magic) || (data.length() < 5) || (data.at(4) != s_version)) {
+    return false;
+  }
+  const char *cursor = data.constData() + 5;
+  const char *end = data.constData() + data.length();
+  while (cursor < end) {
+    quint64 length, serialNumber, address, count;
+    if (!getVarint(&cursor, end, &length) || (length > quint64(end - cursor))) {
+      break;
+    }
+    const char *blockEnd = cursor + length;
+    if (!getVarint(&cursor, blockEnd, &serialNumber) || !getVarint(&cursor, blockEnd, &address) ||
+        !getVarint(&cursor, blockEnd, &count)) {
+      break;
+    }
+    quint64 key = seriesKey(serialNumber, address);
+    if (!seriesIndex.contains(key)) {
+      sampleSeries_t series;
+      series.serialNumber = serialNumber;
+      series.address = address;
+      seriesIndex.insert(key, seriesList->length());
+      seriesList->append(series);
+    }
+    sampleSeries_t &series = (*seriesList)[seriesIndex.value(key)];
+    if (!getColumn(&cursor, blockEnd, count, &series.timestamps) ||
+        !getColumn(&cursor, blockEnd, count, &series.values)) {
+      // keep the columns the same length
+      series.timestamps.resize(qMin(series.timestamps.length(), series.values.length()));
+      series.values.resize(series.timestamps.length());
+      break;
+    }
+    cursor = blockEnd;
+  }
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef SAMPLERECORDER_H
+#define SAMPLERECORDER_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// the samples of one register of one fixture, a column per field
+struct sampleSeries_t {
+  quint32 serialNumber;
+  quint16 address;
+  // milliseconds since the epoch
+  QVector<qint64> timestamps;
+  QVector<qint64> values;
+};
+
+// records register reads to disk as they happen, for captures that run for
+// days. samples are buffered per register and fixture and written as
+// blocks of delta encoded columns to files that are rotated by size.
+class sampleRecorder
+{
+public:
+  explicit sampleRecorder(QString directory = QString(), qint64 maxFileBytes = 16 * 1024 * 1024);
+  ~sampleRecorder();
+  void setRegisters(QList<quint16> addresses);
+  bool isRecorded(quint16 address);
+  void record(quint32 serialNumber, quint16 address, qint64 timestamp, QString response);
+  void flush(void);
+  QString directory(void);
+  static QString defaultDirectory(void);
+  static bool load(QString path, QList<sampleSeries_t> *seriesList);
+
+private:
+  QMutex m_lock;
+  QString m_directory;
+  qint64 m_maxFileBytes;
+  QFile m_file;
+  QList<quint16> m_addresses;
+  QHash<quint64, sampleSeries_t> m_pending;
+  void flushSeries(sampleSeries_t *series);
+  bool openFile(void);
+};
+
+#endif // SAMPLERECORDER_H
@@ -0,0 +1,125 @@
+#include "sessionlog.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+sessionLog::sessionLog(format fileFormat, QString directory, qint64 maxFileBytes) :
+  m_format(fileFormat),
+  m_directory(directory.isEmpty() ? defaultDirectory() : directory),
+  m_maxFileBytes(maxFileBytes),
+  m_name(QString("session-%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"))),
+  m_writerFormat(fileFormat) {
+  m_writerPool.setMaxThreadCount(1);
+  m_writerPool.setExpiryTimeout(-1);
+}
+
+sessionLog::~sessionLog() {
+  // write out whatever is still queued
+  m_writerPool.waitForDone();
+}
+
+QString sessionLog::defaultDirectory(void) {
+  return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("sessions");
+}
+
+// queues the lines for the writer thread and returns right away
+void sessionLog::append(const QList<outputLine_t> &lines) {
+  QStringList text;
+  foreach (const outputLine_t &line, lines) {
+    QString lineText;
+    foreach (const outputSpan_t &span, line) {
+      lineText += span.text;
+    }
+    text << lineText;
+  }
+  QtConcurrent::run(&m_writerPool, this, &sessionLog::write, text, QDateTime::currentMSecsSinceEpoch());
+}
+
+sessionLog::format sessionLog::fileFormat(void) {
+  return m_format;
+}
+
+// lines appended from now on go to a new file of the session in the new
+// format. the files written so far stay part of the session, so saveTo()
+// still has everything.
+void sessionLog::setFileFormat(format fileFormat) {
+  m_format = fileFormat;
+  QtConcurrent::run(&m_writerPool, this, &sessionLog::switchFormat, fileFormat);
+}
+
+void sessionLog::switchFormat(format fileFormat) {
+  m_writerFormat = fileFormat;
+  m_file.close();
+}
+
+// the files of this session, oldest first
+QStringList sessionLog::files(void) {
+  QMutexLocker locker(&m_filesLock);
+  return m_files;
+}
+
+// copies the session so far to path, a chunk at a time
+bool sessionLog::saveTo(QString path) {
+  m_writerPool.waitForDone();
+  QFile out(path);
+  if (!out.open(QFile::WriteOnly | QFile::Truncate)) {
+    return false;
+  }
+  foreach (const QString &file, files()) {
+    QFile in(file);
+    if (!in.open(QFile::ReadOnly)) {
+      return false;
+    }
+    while (!in.atEnd()) {
+      if (out.write(in.read(64 * 1024)) < 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void sessionLog::write(QStringList lines, qint64 timestamp) {
+  if (!openFile()) {
+    return;
+  }
+  QByteArray data;
+  if (m_writerFormat == FORMAT_JSON) {
+    QString time = QDateTime::fromMSecsSinceEpoch(timestamp).toString("yyyy-MM-ddTHH:mm:ss.zzz");
+    foreach (const QString &line, lines) {
+      QJsonObject object;
+      object.insert("time", time);
+      object.insert("text", line);
+      data += QJsonDocument(object).toJson(QJsonDocument::Compact) + "\n";
+    }
+  } else {
+    foreach (const QString &line, lines) {
+      data += line.toUtf8() + "\n";
+    }
+  }
+  m_file.write(data);
+  // don't leave lines in a buffer a crash would lose
+  m_file.flush();
+}
+
+// starts the next file when there is none yet or the current one is full
+bool sessionLog::openFile(void) {
+  if (m_file.isOpen() && (m_file.size() < m_maxFileBytes)) {
+    return true;
+  }
+  m_file.close();
+  QDir().mkpath(m_directory);
+  QMutexLocker locker(&m_filesLock);
+  QString suffix = (m_writerFormat == FORMAT_JSON) ? "jsonl" : "txt";
+  QString path = QDir(m_directory).filePath(QString("%1-%2.%3").arg(m_name).arg(m_files.length() + 1).arg(suffix));
+  m_file.setFileName(path);
+  if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+    return false;
+  }
+  m_files << path;
+  return true;
+}
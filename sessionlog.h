@@ -0,0 +1,48 @@
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include "outputmodel.h"
+
+// a copy of everything printed to the output pane, written to disk as it
+// happens on a background thread, so the history survives a crash and
+// isn't limited by the scrollback
+class sessionLog
+{
+public:
+  enum format {
+    FORMAT_TEXT,
+    // one {"time", "text"} object per line
+    FORMAT_JSON
+  };
+  explicit sessionLog(format fileFormat = FORMAT_TEXT, QString directory = QString(), qint64 maxFileBytes = 8 * 1024 * 1024);
+  ~sessionLog();
+  void append(const QList<outputLine_t> &lines);
+  QStringList files(void);
+  format fileFormat(void);
+  void setFileFormat(format fileFormat);
+  bool saveTo(QString path);
+  static QString defaultDirectory(void);
+
+private:
+  // format of the lines appended from now on
+  format m_format;
+  QString m_directory;
+  qint64 m_maxFileBytes;
+  QString m_name;
+  // only touched by the writer thread
+  format m_writerFormat;
+  QFile m_file;
+  QStringList m_files;
+  QMutex m_filesLock;
+  // a single thread, so lines are written in the order they were printed
+  QThreadPool m_writerPool;
+  void write(QStringList lines, qint64 timestamp);
+  void switchFormat(format fileFormat);
+  bool openFile(void);
+};
+
+#endif // SESSIONLOG_H
@@ -1,31 +1,34 @@
 #include "solarized.h"
-#include <QHash>
+#include <QVector>
 #include <QLineEdit>
-#include <QTextEdit>
+#include <QListView>
 #include <QScrollBar>
 #include <QFrame>
 
 solarized::solarized(QObject *parent) : QObject(parent){}
 
-void solarized::setTextColor(QString *text, solarizedColor color) {
-  QHash <solarizedColor, QString> colorTable;
-  colorTable.insert(SOLAR_BASE_03, "#002b36");
-  colorTable.insert(SOLAR_BASE_02, "#073642");
-  colorTable.insert(SOLAR_BASE_01, "#586e75");
-  colorTable.insert(SOLAR_BASE_00, "#657b83");
-  colorTable.insert(SOLAR_BASE_0, "#839496");
-  colorTable.insert(SOLAR_BASE_1, "#93a1a1");
-  colorTable.insert(SOLAR_BASE_2, "#eee8d5");
-  colorTable.insert(SOLAR_BASE_3, "#fdf6e3");
-  colorTable.insert(SOLAR_YELLOW, "#b58900");
-  colorTable.insert(SOLAR_ORANGE, "#cb4b16");
-  colorTable.insert(SOLAR_RED, "#dc322f");
-  colorTable.insert(SOLAR_MAGENTA, "#d33682");
-  colorTable.insert(SOLAR_VIOLET, "#6c71c4");
-  colorTable.insert(SOLAR_BLUE, "#268bd2");
-  colorTable.insert(SOLAR_CYAN, "#2aa198");
-  colorTable.insert(SOLAR_GREEN, "#859900");
-  *text = QString("%1%2%3%4%5").arg("<font color=\"").arg(colorTable[color]).arg("\">").arg(*text).arg("<\\font>");
+// in solarizedColor order
+static const QRgb s_colorTable[] = {
+  0x002b36, 0x073642, 0x586e75, 0x657b83,
+  0x839496, 0x93a1a1,
+  0xeee8d5, 0xfdf6e3,
+  0xb58900, 0xcb4b16, 0xdc322f, 0xd33682, 0x6c71c4, 0x268bd2, 0x2aa198, 0x859900
+};
+static const int s_numColors = sizeof(s_colorTable) / sizeof(s_colorTable[0]);
+
+static QVector<QColor> buildColors(void) {
+  QVector<QColor> colors;
+  for (int i = 0; i < s_numColors; i++) {
+    colors << QColor(s_colorTable[i]);
+  }
+  return colors;
+}
+
+// painted for every span of every visible output line, so the colors are
+// only built once
+const QColor &solarized::color(solarizedColor color) {
+  static const QVector<QColor> colors = buildColors();
+  return colors.at(color);
 }
 
 void solarized::setStyleSheetQLineEdit(QLineEdit *lineEdit) {
@@ -45,8 +48,8 @@ void solarized::setStyleSheetQLineEdit(QLineEdit *lineEdit) {
   lineEdit->setStyleSheet(lineEditQss);
 }
 
-void solarized::setStyleSheetQTextEdit(QTextEdit *textEdit) {
-  QString textEditQss = "QTextEdit {"
+void solarized::setStyleSheetQListView(QListView *listView) {
+  QString listViewQss = "QListView {"
                         "font-family: Consolas;"
                         "font-style: normal;"
                         "font-size: 14pt;"
@@ -55,6 +58,7 @@ void solarized::setStyleSheetQTextEdit(QTextEdit *textEdit) {
                         "border-radius: 0px;"
                         "padding: 0px;"
                         "background-color: #fdf6e3;"
+                        "selection-background-color: #eee8d5;"
                         "color: #073642;"
                         "}";
   QString scrollBarQss = "QScrollBar {"
@@ -63,8 +67,8 @@ void solarized::setStyleSheetQTextEdit(QTextEdit *textEdit) {
                          "QScrollBar::handle {"
                          "background: #eee8d5;"
                          "}";
-  textEdit->setStyleSheet(textEditQss);
-  textEdit->verticalScrollBar()->setStyleSheet(scrollBarQss);
+  listView->setStyleSheet(listViewQss);
+  listView->verticalScrollBar()->setStyleSheet(scrollBarQss);
 }
 
 void solarized::setStyleSheetQFrame(QFrame *frame) {
@@ -3,8 +3,9 @@
 
 #include <QObject>
 #include <QHash>
+#include <QColor>
 
-class QTextEdit;
+class QListView;
 class QLineEdit;
 class QFrame;
 
@@ -24,9 +25,9 @@ public:
   };
   explicit solarized(QObject *parent = 0);
   static void setStyleSheetQLineEdit(QLineEdit *lineEdit);
-  static void setStyleSheetQTextEdit(QTextEdit *textEdit);
+  static void setStyleSheetQListView(QListView *listView);
   static void setStyleSheetQFrame(QFrame *frame);
-  static void setTextColor(QString *text, solarizedColor color);
+  static const QColor &color(solarizedColor color);
 
 signals:
 public slots: 